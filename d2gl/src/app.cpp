@@ -17,6 +17,7 @@
 */
 
 #include "pch.h"
+#include "asset_cache.h"
 #include "d2/common.h"
 #include "helpers.h"
 #include "option/config.h"
@@ -112,7 +113,9 @@ void dllDetach()
 	if (App.hmodule) {
 		win32::destroyHooks();
 		d2::destroyHooks();
+		AssetCache::Instance().flush();
 		timeEndPeriod(1);
+		logFlush();
 		exit(EXIT_SUCCESS);
 	}
 }
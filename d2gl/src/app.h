@@ -47,6 +47,7 @@ struct D2GLApp {
 	std::string json_backup = "d2gl.json.bak";
 	std::string mpq_file = "d2gl.mpq";
 	std::string log_file = "d2gl.log";
+	std::string cache_dir = "d2gl_cache\\";
 
 	d2gl::Config config;
 	Api api = Api::Glide;
@@ -144,6 +145,18 @@ struct D2GLApp {
 		Range<float> gamma = { 0.75f, 0.5f, 1.2f };
 	} bloom;
 
+	struct {
+		bool active = false;
+		Range<int> target_fps = { 60, 30, 240 };
+		uint32_t level = 0;
+	} governor;
+
+	struct {
+		bool active = false;
+		Range<float> min_scale = { 0.5f, 0.25f, 1.0f };
+		float scale = 1.0f;
+	} dynamic_resolution;
+
 	struct {
 		bool active = true;
 		Range<float> scale = { 1.0f, 0.8f, 1.0f };
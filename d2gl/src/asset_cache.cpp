@@ -0,0 +1,291 @@
+/*
+	D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+	Copyright (C) 2023  Bayaraa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "asset_cache.h"
+#include "d2/common.h"
+#include "helpers.h"
+
+namespace d2gl {
+
+#define ASSET_CACHE_MAGIC 0x43413244 // "D2AC"
+
+static uint64_t blobHash(const void* data, size_t len)
+{
+	// 64-bit FNV-1a, blobs are shared by content so 32 bits are not enough to rule out collisions.
+	const uint8_t* bytes = (const uint8_t*)data;
+	uint64_t hash = 0xcbf29ce484222325;
+	for (size_t i = 0; i < len; i++) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3;
+	}
+	return hash;
+}
+
+Asset::Asset(std::unique_ptr<uint8_t[]> buffer, size_t size)
+	: m_data(buffer.get()), m_size(size), m_buffer(std::move(buffer))
+{}
+
+Asset::Asset(HANDLE file, HANDLE mapping, const void* view, size_t size)
+	: m_data((const uint8_t*)view), m_size(size), m_file(file), m_mapping(mapping)
+{}
+
+Asset::~Asset()
+{
+	if (m_mapping) {
+		UnmapViewOfFile(m_data);
+		CloseHandle(m_mapping);
+	}
+
+	if (m_file != INVALID_HANDLE_VALUE)
+		CloseHandle(m_file);
+}
+
+AssetRef AssetCache::get(const std::string& file_path, bool log_missing)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!m_initialized)
+		init();
+
+	auto it = m_assets.find(file_path);
+	if (it != m_assets.end()) {
+		if (auto asset = it->second.lock()) {
+			m_stats.shared++;
+			return asset;
+		}
+	}
+
+	AssetRef asset;
+	auto entry = m_index.find(file_path);
+	if (entry != m_index.end())
+		asset = map(entry->second);
+
+	if (!asset)
+		asset = extract(file_path, log_missing);
+
+	if (asset)
+		m_assets[file_path] = asset;
+
+	return asset;
+}
+
+void AssetCache::flush()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_index_dirty)
+		saveIndex();
+}
+
+void AssetCache::init()
+{
+	m_initialized = true;
+
+	std::error_code ec;
+	const std::string mpq_path = helpers::getCurrentDir() + App.mpq_file;
+	const uint64_t mpq_size = std::filesystem::file_size(mpq_path, ec);
+	const uint64_t mpq_time = std::filesystem::last_write_time(mpq_path, ec).time_since_epoch().count();
+	m_mpq_stamp = mpq_size * 0x9E3779B97F4A7C15 ^ mpq_time;
+
+	if (!loadIndex()) {
+		m_index.clear();
+		std::filesystem::remove_all(App.cache_dir + "assets", ec);
+	}
+	trace_log("Asset cache: %u files indexed.", (uint32_t)m_index.size());
+}
+
+AssetRef AssetCache::map(const AssetIndexEntry& entry)
+{
+	if (!entry.size)
+		return std::make_shared<const Asset>(std::make_unique<uint8_t[]>(1), 0);
+
+	HANDLE file = CreateFileA(getBlobPath(entry).c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart != entry.size) {
+		CloseHandle(file);
+		return nullptr;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	const void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!view) {
+		if (mapping)
+			CloseHandle(mapping);
+		CloseHandle(file);
+		return nullptr;
+	}
+
+	m_stats.mapped++;
+	return std::make_shared<const Asset>(file, mapping, view, entry.size);
+}
+
+AssetRef AssetCache::extract(const std::string& file_path, bool log_missing)
+{
+	if (!m_mpq_loaded) {
+		std::string mpq_path = helpers::getCurrentDir() + App.mpq_file;
+		if (!d2::mpqLoad(mpq_path.c_str()))
+			error_log("%s not loaded.", mpq_path.c_str());
+		m_mpq_loaded = true;
+	}
+
+	std::string path = std::string("data\\").append(file_path);
+
+	void* ref_file;
+	char c_filepath[MAX_PATH];
+	strncpy_s(c_filepath, path.c_str(), path.size());
+
+	if (!d2::mpqOpenFile || !d2::mpqOpenFile(c_filepath, &ref_file)) {
+		if (log_missing)
+			error_log("File (MPQ): \"%s\" could not opened!", path.c_str());
+		return nullptr;
+	}
+
+	uint32_t return_size = 0;
+	const uint32_t file_size = d2::mpqGetFileSize(ref_file, NULL);
+	auto buffer = std::make_unique<uint8_t[]>(file_size + 1);
+
+	const bool read = d2::mpqReadFile(ref_file, buffer.get(), file_size, &return_size, NULL, NULL, NULL);
+	d2::mpqCloseFile(ref_file);
+	if (!read) {
+		error_log("File (MPQ): \"%s\" read error.", path.c_str());
+		return nullptr;
+	}
+	buffer[return_size] = 0;
+
+	// Blobs are named by content, files shared between paths are stored once.
+	const AssetIndexEntry entry = { blobHash(buffer.get(), return_size), return_size };
+	const auto blob_path = getBlobPath(entry);
+
+	std::error_code ec;
+	bool stored = !return_size || std::filesystem::file_size(blob_path, ec) == return_size;
+	if (!stored) {
+		std::filesystem::create_directories(App.cache_dir + "assets", ec);
+
+		const auto temp_path = blob_path + "." + std::to_string(GetCurrentThreadId());
+		std::ofstream file(temp_path, std::ios::binary);
+		if (file.is_open()) {
+			file.write((const char*)buffer.get(), return_size);
+			file.close();
+			if (file) {
+				std::filesystem::rename(temp_path, blob_path, ec);
+				stored = !ec;
+			}
+			if (!stored)
+				std::filesystem::remove(temp_path, ec);
+		}
+	}
+
+	if (stored) {
+		m_index[file_path] = entry;
+		m_index_dirty = true;
+	}
+
+	m_stats.extracted++;
+	return std::make_shared<const Asset>(std::move(buffer), return_size);
+}
+
+bool AssetCache::loadIndex()
+{
+	std::ifstream file(App.cache_dir + "assets\\index.bin", std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return false;
+
+	const uint64_t file_size = (uint64_t)file.tellg();
+	file.seekg(0);
+
+	auto readU32 = [&file]() {
+		uint32_t value = 0;
+		file.read((char*)&value, sizeof(value));
+		return value;
+	};
+
+	if (readU32() != ASSET_CACHE_MAGIC || readU32() != ASSET_CACHE_VERSION)
+		return false;
+
+	uint64_t mpq_stamp = 0;
+	file.read((char*)&mpq_stamp, sizeof(mpq_stamp));
+	if (mpq_stamp != m_mpq_stamp)
+		return false;
+
+	const uint32_t count = readU32();
+	for (uint32_t i = 0; i < count && file; i++) {
+		const uint32_t length = readU32();
+		if (!file || length > file_size - (uint64_t)file.tellg())
+			return false;
+
+		std::string path(length, '\0');
+		file.read(path.data(), path.size());
+
+		AssetIndexEntry entry;
+		file.read((char*)&entry.hash, sizeof(entry.hash));
+		entry.size = readU32();
+		m_index[path] = entry;
+	}
+
+	return (bool)file;
+}
+
+void AssetCache::saveIndex()
+{
+	const auto file_path = App.cache_dir + "assets\\index.bin";
+	const auto temp_path = file_path + "." + std::to_string(GetCurrentThreadId());
+	std::error_code ec;
+	std::filesystem::create_directories(App.cache_dir + "assets", ec);
+	{
+		std::ofstream file(temp_path, std::ios::binary);
+		if (!file.is_open())
+			return;
+
+		auto writeU32 = [&file](uint32_t value) { file.write((const char*)&value, sizeof(value)); };
+
+		writeU32(ASSET_CACHE_MAGIC);
+		writeU32(ASSET_CACHE_VERSION);
+		file.write((const char*)&m_mpq_stamp, sizeof(m_mpq_stamp));
+
+		writeU32((uint32_t)m_index.size());
+		for (auto& it : m_index) {
+			writeU32((uint32_t)it.first.size());
+			file.write(it.first.data(), it.first.size());
+			file.write((const char*)&it.second.hash, sizeof(it.second.hash));
+			writeU32(it.second.size);
+		}
+
+		file.close();
+		if (!file) {
+			std::filesystem::remove(temp_path, ec);
+			return;
+		}
+	}
+
+	m_index_dirty = false;
+	std::filesystem::rename(temp_path, file_path, ec);
+	if (ec)
+		std::filesystem::remove(temp_path, ec);
+}
+
+std::string AssetCache::getBlobPath(const AssetIndexEntry& entry)
+{
+	char file_name[40] = { 0 };
+	sprintf_s(file_name, "%016llx_%08x.bin", (unsigned long long)entry.hash, entry.size);
+
+	return App.cache_dir + "assets\\" + file_name;
+}
+
+}
@@ -0,0 +1,95 @@
+/*
+	D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+	Copyright (C) 2023  Bayaraa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// Bump when the index layout changes. A changed mpq (size or write time) drops the whole cache.
+#define ASSET_CACHE_VERSION 2
+
+namespace d2gl {
+
+// Read-only file contents, either a mapped view of a cached file or a buffer read from the mpq.
+class Asset {
+	const uint8_t* m_data = nullptr;
+	size_t m_size = 0;
+	std::unique_ptr<uint8_t[]> m_buffer;
+	HANDLE m_file = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = nullptr;
+
+public:
+	Asset(std::unique_ptr<uint8_t[]> buffer, size_t size);
+	Asset(HANDLE file, HANDLE mapping, const void* view, size_t size);
+	~Asset();
+
+	inline const uint8_t* getData() const { return m_data; }
+	inline size_t getSize() const { return m_size; }
+	inline std::string getString() const { return std::string((const char*)m_data, m_size); }
+	inline bool isMapped() const { return m_mapping != nullptr; }
+};
+
+typedef std::shared_ptr<const Asset> AssetRef;
+
+struct AssetIndexEntry {
+	uint64_t hash = 0;
+	uint32_t size = 0;
+};
+
+struct AssetCacheStats {
+	uint32_t shared = 0;
+	uint32_t mapped = 0;
+	uint32_t extracted = 0;
+};
+
+class AssetCache {
+	std::mutex m_mutex;
+	bool m_initialized = false;
+	bool m_mpq_loaded = false;
+	bool m_index_dirty = false;
+	uint64_t m_mpq_stamp = 0;
+	std::unordered_map<std::string, AssetIndexEntry> m_index;
+	std::unordered_map<std::string, std::weak_ptr<const Asset>> m_assets;
+	AssetCacheStats m_stats;
+
+	AssetCache() = default;
+	~AssetCache() = default;
+
+public:
+	static AssetCache& Instance()
+	{
+		static AssetCache instance;
+		return instance;
+	}
+
+	// Paths are relative to the mpq data folder. Returns nullptr when the file is missing.
+	AssetRef get(const std::string& file_path, bool log_missing = true);
+	// Writes the index when files were extracted since the last write.
+	void flush();
+
+	inline const AssetCacheStats& getStats() const { return m_stats; }
+
+private:
+	void init();
+	AssetRef map(const AssetIndexEntry& entry);
+	AssetRef extract(const std::string& file_path, bool log_missing);
+
+	bool loadIndex();
+	void saveIndex();
+	std::string getBlobPath(const AssetIndexEntry& entry);
+};
+
+}
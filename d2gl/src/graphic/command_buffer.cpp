@@ -23,8 +23,10 @@ void CommandBuffer::reset()
 	m_tex_update_queue.count = 0;
 	m_tex_update_queue.data_offset = 0;
 	m_vertex_count = 0;
-	m_vertex_mod_count = 0;
+	m_instance_mod_count = 0;
 	m_tex_update.bit = 0;
+	m_tex_update.data_size = 0;
+	m_tex_update.region_count = 0;
 
 	m_screen = App.game.screen;
 	m_window_size = App.window.size;
@@ -89,9 +91,39 @@ void CommandBuffer::textureUpdate(uint8_t* data, uint16_t tex_num, glm::vec<2, u
 
 void CommandBuffer::gameTextureUpdate(uint8_t* data, glm::vec<2, uint16_t> size, uint32_t bit)
 {
-	memcpy(m_tex_buffer, data, size.x * size.y * bit);
+	m_tex_update.data_size = size.x * size.y * bit;
+	memcpy(m_tex_buffer, data, m_tex_update.data_size);
 	m_tex_update.bit = bit;
-	m_tex_update.size = size;
+	m_tex_update.region_count = 1;
+	m_tex_update.regions[0] = { 0, { 0, 0 }, size };
+}
+
+void CommandBuffer::gameTextureUpdate(uint8_t* data, glm::vec<2, uint16_t> size, uint32_t bit, const std::vector<DirtyRegion>& regions)
+{
+	const uint32_t pitch = size.x * bit;
+	uint32_t offset = 0;
+	uint32_t count = 0;
+
+	for (auto& region : regions) {
+		if (count >= MAX_DIRTY_REGIONS)
+			break;
+
+		const uint32_t row_size = region.size.x * bit;
+		const uint8_t* src = data + region.pos.y * pitch + region.pos.x * bit;
+		if (region.size.x == size.x)
+			memcpy(m_tex_buffer + offset, src, row_size * region.size.y);
+		else {
+			for (uint32_t y = 0; y < region.size.y; y++)
+				memcpy(m_tex_buffer + offset + y * row_size, src + y * pitch, row_size);
+		}
+
+		m_tex_update.regions[count++] = { offset, region.pos, region.size };
+		offset += row_size * region.size.y;
+	}
+
+	m_tex_update.bit = bit;
+	m_tex_update.data_size = offset;
+	m_tex_update.region_count = count;
 }
 
 void CommandBuffer::setHDTextMasking(bool masking, glm::vec4 metrics)
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "dirty_tiles.h"
+
 namespace d2gl {
 
 enum class CommandType {
@@ -52,9 +54,17 @@ struct UBOUpdateQueue {
 	std::array<UBOData, 16> data;
 };
 
+struct GameTexRegion {
+	uint32_t offset;
+	glm::vec<2, uint16_t> pos;
+	glm::vec<2, uint16_t> size;
+};
+
 struct GameTexUpdate {
 	uint32_t bit = 0;
-	glm::vec<2, uint16_t> size = { 0, 0 };
+	uint32_t data_size = 0;
+	uint32_t region_count = 0;
+	std::array<GameTexRegion, MAX_DIRTY_REGIONS> regions = {};
 };
 
 struct HDTextMasking {
@@ -71,7 +81,7 @@ class CommandBuffer {
 	UBOUpdateQueue m_ubo_update_queue;
 	TexUpdateQueue m_tex_update_queue;
 	uint32_t m_vertex_count = 0;
-	uint32_t m_vertex_mod_count = 0;
+	uint32_t m_instance_mod_count = 0;
 	GameScreen m_screen = GameScreen::InGame;
 
 	bool m_resized = false;
@@ -99,6 +109,7 @@ public:
 	void colorUpdate(UBOType type, const void* data);
 	void textureUpdate(uint8_t* data, uint16_t tex_num, glm::vec<2, uint16_t> size, glm::vec<2, uint16_t> offset);
 	void gameTextureUpdate(uint8_t* data, glm::vec<2, uint16_t> size, uint32_t bit = 1);
+	void gameTextureUpdate(uint8_t* data, glm::vec<2, uint16_t> size, uint32_t bit, const std::vector<DirtyRegion>& regions);
 	void setHDTextMasking(bool masking, glm::vec4 metrics);
 };
 
@@ -20,11 +20,14 @@
 #include "context.h"
 #include "d2/common.h"
 #include "helpers.h"
+#include "image_decoder.h"
 #include "modules/hd_cursor.h"
 #include "modules/hd_text.h"
 #include "modules/mini_map.h"
 #include "modules/motion_prediction.h"
 #include "option/menu.h"
+#include "resource_pool.h"
+#include "screen_capture.h"
 #include "upscaler.h"
 #include "win32.h"
 
@@ -36,6 +39,11 @@ namespace d2gl {
 
 Context::Context()
 {
+	// Decoded on a worker while the context and pipelines are set up.
+	ImageDecoder image_decoder;
+	if (ISGLIDE3X())
+		image_decoder.add("assets\\textures\\lut.png", false);
+
 	PIXELFORMATDESCRIPTOR pfd;
 	memset(&pfd, 0, sizeof(PIXELFORMATDESCRIPTOR));
 	pfd.nSize = sizeof(PIXELFORMATDESCRIPTOR);
@@ -107,7 +115,8 @@ Context::Context()
 
 	if ((App.debug || App.log) && glewIsSupported("GL_KHR_debug")) {
 		glEnable(GL_DEBUG_OUTPUT);
-		glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+		if (App.debug)
+			glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
 		glDebugMessageCallback(Context::debugMessageCallback, nullptr);
 		glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
 		trace_log("OpenGL: GL_KHR_debug enabled!");
@@ -123,11 +132,22 @@ Context::Context()
 		trace_log("OpenGL: Independent blending available.");
 	}
 
+	if (glewIsSupported("GL_VERSION_4_1") || glewIsSupported("GL_ARB_get_program_binary")) {
+		GLint binary_formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binary_formats);
+		if (binary_formats > 0) {
+			App.gl_caps.program_binary = true;
+			trace_log("OpenGL: Program binary cache available.");
+		}
+	}
+
 	glDisable(GL_CULL_FACE);
 	glDisable(GL_DEPTH_TEST);
 	glDisable(GL_STENCIL_TEST);
 
-	glEnable(GL_BLEND);
+	auto& state = GLState::Instance();
+	state.invalidate();
+	state.setBlend(true);
 	glBlendEquation(GL_FUNC_ADD);
 
 	uint32_t offset = 0;
@@ -143,7 +163,7 @@ Context::Context()
 	}
 
 	glGenVertexArrays(1, &m_vertex_array);
-	glBindVertexArray(m_vertex_array);
+	state.bindVertexArray(m_vertex_array);
 
 	glGenBuffers(1, &m_index_buffer);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_index_buffer);
@@ -151,16 +171,29 @@ Context::Context()
 	delete[] indices;
 
 	glGenBuffers(1, &m_vertex_buffer);
-	glBindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer);
+	state.bindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer);
 	glBufferData(GL_ARRAY_BUFFER, sizeof(m_vertices.data[0]), NULL, GL_DYNAMIC_DRAW);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	state.bindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glGenVertexArrays(1, &m_instance_array);
+	state.bindVertexArray(m_instance_array);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_index_buffer);
+
+	glGenBuffers(1, &m_instance_buffer);
+	state.bindBuffer(GL_ARRAY_BUFFER, m_instance_buffer);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(m_instances_mod.data[0]), NULL, GL_DYNAMIC_DRAW);
+	InstanceMod::bindingDescription();
+
+	state.bindVertexArray(m_vertex_array);
+	state.bindBuffer(GL_ARRAY_BUFFER, m_vertex_buffer);
 
 	glGenBuffers(1, &m_pixel_buffer);
-	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixel_buffer);
+	state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixel_buffer);
 	glBufferData(GL_PIXEL_UNPACK_BUFFER, PIXEL_BUFFER_SIZE, NULL, GL_DYNAMIC_DRAW);
-	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
 	imguiInit();
+	state.invalidate();
 
 	PipelineCreateInfo movie_pipeline_ci = { "movie" };
 	movie_pipeline_ci.shader = g_shader_movie;
@@ -170,6 +203,7 @@ Context::Context()
 	UniformBufferCreateInfo postfx_ubo_ci;
 	postfx_ubo_ci.variables = { { "sharpen", sizeof(glm::vec4) }, { "rel_size", sizeof(glm::vec2) } };
 	m_postfx_ubo = Context::createUniformBuffer(postfx_ubo_ci);
+	m_sharpen_var = m_postfx_ubo->getHandle("sharpen");
 
 	m_sharpen_data = { App.sharpen.strength.value, App.sharpen.clamp.value, App.sharpen.radius.value };
 	m_postfx_ubo->updateDataVec4f("sharpen", glm::vec4(m_sharpen_data, 1.0f));
@@ -178,22 +212,21 @@ Context::Context()
 	postfx_pipeline_ci.shader = g_shader_postfx;
 	postfx_pipeline_ci.bindings = {
 		{ BindingType::UniformBuffer, "ubo_Metrics", m_postfx_ubo->getBinding() },
-		{ BindingType::FBTexture, "u_Texture0", TEXTURE_SLOT_POSTFX1, &m_postfx_framebuffer },
-		{ BindingType::Texture, "u_Texture1", TEXTURE_SLOT_POSTFX2, &m_postfx_texture },
 	};
 	m_postfx_pipeline = Context::createPipeline(postfx_pipeline_ci);
 	m_postfx_pipeline->setUniformMat4f("u_MVP", glm::ortho(-1.0f, 1.0f, -1.0f, 1.0f));
+	m_postfx_input_uniform = m_postfx_pipeline->getUniformHandle("u_Texture0");
 
 	if (App.gl_caps.compute_shader) {
 		PipelineCreateInfo fxaa_pipeline_ci = { "compute fxaa" };
 		fxaa_pipeline_ci.shader = g_shader_postfx;
 		fxaa_pipeline_ci.version = { 4, 3 };
 		fxaa_pipeline_ci.bindings = {
-			{ BindingType::Texture, "u_InTexture", TEXTURE_SLOT_POSTFX2, &m_postfx_texture },
 			{ BindingType::Image, "u_OutTexture", IMAGE_UNIT_FXAA },
 		};
 		fxaa_pipeline_ci.compute = true;
 		m_fxaa_compute_pipeline = Context::createPipeline(fxaa_pipeline_ci);
+		m_fxaa_input_uniform = m_fxaa_compute_pipeline->getUniformHandle("u_InTexture");
 	}
 
 	PipelineCreateInfo mod_pipeline_ci = { "module" };
@@ -209,6 +242,8 @@ Context::Context()
 	}
 	m_mod_pipeline = Context::createPipeline(mod_pipeline_ci);
 	m_mod_pipeline->setUniform1i("u_IsGlide", ISGLIDE3X());
+	m_text_mask_uniform = m_mod_pipeline->getUniformHandle("u_TextMask");
+	m_is_masking_uniform = m_mod_pipeline->getUniformHandle("u_IsMasking");
 
 	if (ISGLIDE3X()) {
 		TextureCreateInfo glide_texture_ci;
@@ -226,6 +261,8 @@ Context::Context()
 		UniformBufferCreateInfo game_ubo_ci;
 		game_ubo_ci.variables = { { "palette", 256 * sizeof(glm::vec4) }, { "gamma", 256 * sizeof(glm::vec4) } };
 		m_game_color_ubo = Context::createUniformBuffer(game_ubo_ci);
+		m_game_color_vars[(int)UBOType::Gamma] = m_game_color_ubo->getHandle("gamma");
+		m_game_color_vars[(int)UBOType::Palette] = m_game_color_ubo->getHandle("palette");
 
 		PipelineCreateInfo game_pipeline_ci = { "glide" };
 		game_pipeline_ci.version = { 3, 3 };
@@ -245,7 +282,7 @@ Context::Context()
 		lut_texture_ci.slot = TEXTURE_SLOT_LUT;
 		m_lut_texture = Context::createTexture(lut_texture_ci);
 
-		auto image_data = helpers::loadImage("assets\\textures\\lut.png", false);
+		auto image_data = image_decoder.get(0);
 		m_lut_texture->fillImage(image_data, 1, 14);
 		helpers::clearImage(image_data);
 
@@ -254,16 +291,17 @@ Context::Context()
 			blur_pipeline_ci.shader = g_shader_prefx;
 			blur_pipeline_ci.version = { 4, 3 };
 			blur_pipeline_ci.bindings = {
-				{ BindingType::Texture, "u_InTexture", TEXTURE_SLOT_BLOOM2, &m_bloom_texture },
 				{ BindingType::Image, "u_OutTexture", IMAGE_UNIT_BLUR },
 			};
 			blur_pipeline_ci.compute = true;
 			m_blur_compute_pipeline = Context::createPipeline(blur_pipeline_ci);
+			m_blur_input_uniform = m_blur_compute_pipeline->getUniformHandle("u_InTexture");
 		}
 
 		UniformBufferCreateInfo bloom_ubo_ci;
 		bloom_ubo_ci.variables = { { "bloom", sizeof(glm::vec2) }, { "rel_size", sizeof(glm::vec2) } };
 		m_bloom_ubo = Context::createUniformBuffer(bloom_ubo_ci);
+		m_bloom_var = m_bloom_ubo->getHandle("bloom");
 
 		m_bloom_data = { App.bloom.exposure.value, App.bloom.gamma.value };
 		m_bloom_ubo->updateDataVec2f("bloom", m_bloom_data);
@@ -272,17 +310,18 @@ Context::Context()
 		prefx_pipeline_ci.shader = g_shader_prefx;
 		prefx_pipeline_ci.bindings = {
 			{ BindingType::UniformBuffer, "ubo_Metrics", m_bloom_ubo->getBinding() },
-			{ BindingType::Texture, "u_Texture", TEXTURE_SLOT_PREFX, &m_prefx_texture },
-			{ BindingType::FBTexture, "u_BloomTexture1", TEXTURE_SLOT_BLOOM1, &m_bloom_framebuffer },
-			{ BindingType::Texture, "u_BloomTexture2", TEXTURE_SLOT_BLOOM2, &m_bloom_texture },
 			{ BindingType::Texture, "u_LUTTexture", m_lut_texture->getSlot(), &m_lut_texture },
 		};
 		m_prefx_pipeline = Context::createPipeline(prefx_pipeline_ci);
 		m_prefx_pipeline->setUniformMat4f("u_MVP", glm::ortho(-1.0f, 1.0f, -1.0f, 1.0f));
+		m_prefx_texture_uniform = m_prefx_pipeline->getUniformHandle("u_Texture");
+		m_bloom_uniform = m_prefx_pipeline->getUniformHandle("u_BloomTexture1");
+		m_bloom_input_uniform = m_prefx_pipeline->getUniformHandle("u_BloomTexture2");
 	} else {
 		UniformBufferCreateInfo ubo_ci;
 		ubo_ci.variables = { { "palette", 256 * sizeof(glm::vec4) } };
 		m_game_color_ubo = Context::createUniformBuffer(ubo_ci);
+		m_game_color_vars[(int)UBOType::Palette] = m_game_color_ubo->getHandle("palette");
 
 		PipelineCreateInfo game_pipeline_ci = { "ddraw" };
 		game_pipeline_ci.shader = g_shader_ddraw;
@@ -304,8 +343,8 @@ Context::Context()
 	m_limiter.timer = CreateWaitableTimer(NULL, TRUE, NULL);
 	setFpsLimit(!App.vsync && App.foreground_fps.active, App.foreground_fps.range.value);
 
-	m_vertices_mod.count = 0;
-	m_vertices_mod.ptr = m_vertices_mod.data[m_frame_index].data();
+	m_instances_mod.count = 0;
+	m_instances_mod.ptr = m_instances_mod.data[m_frame_index].data();
 
 	m_frame.vertex_count = 0;
 	m_frame.drawcall_count = 0;
@@ -334,11 +373,15 @@ Context::~Context()
 
 	wglMakeCurrent(App.hdc, m_context);
 	imguiDestroy();
+	ScreenCapture::Instance().destroy();
 
 	glDeleteBuffers(1, &m_pixel_buffer);
 	glDeleteBuffers(1, &m_vertex_buffer);
 	glDeleteBuffers(1, &m_index_buffer);
+	glDeleteBuffers(1, &m_instance_buffer);
+	glDeleteVertexArrays(1, &m_instance_array);
 	glDeleteVertexArrays(1, &m_vertex_array);
+	ResourcePool::Instance().clear();
 
 	wglMakeCurrent(NULL, NULL);
 	wglDeleteContext(m_context);
@@ -350,7 +393,10 @@ void Context::renderThread(void* context)
 	wglMakeCurrent(App.hdc, ctx->m_context);
 	uint32_t frame_index = 0;
 
-	glBindBuffer(GL_ARRAY_BUFFER, ctx->m_vertex_buffer);
+	auto& state = GLState::Instance();
+	state.invalidate();
+	state.bindVertexArray(ctx->m_vertex_array);
+	state.bindBuffer(GL_ARRAY_BUFFER, ctx->m_vertex_buffer);
 	Vertex::enableAttribArray();
 
 	while (ctx->m_rendering) {
@@ -363,24 +409,34 @@ void Context::renderThread(void* context)
 		if (ctx->m_current_shader != App.shader.selected)
 			ctx->onShaderChange();
 
+		ctx->updateQuality();
+
+		LARGE_INTEGER render_start;
+		QueryPerformanceCounter(&render_start);
+
+		state.bindVertexArray(ctx->m_vertex_array);
+		state.bindBuffer(GL_ARRAY_BUFFER, ctx->m_vertex_buffer);
 		if (cmd->m_vertex_count)
 			glBufferSubData(GL_ARRAY_BUFFER, 0, cmd->m_vertex_count * sizeof(Vertex), ctx->m_vertices.data[frame_index].data());
 
 		if (cmd->m_tex_update_queue.count) {
-			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ctx->m_pixel_buffer);
+			state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, ctx->m_pixel_buffer);
 			glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, cmd->m_tex_update_queue.data_offset, cmd->m_tex_buffer);
 			for (uint32_t i = 0; i < cmd->m_tex_update_queue.count; i++) {
 				const auto data = &cmd->m_tex_update_queue.tex_data[i];
 				ctx->m_glide_texture->fill((uint8_t*)data->offset, data->tex_size.x, data->tex_size.y, data->tex_offset.x, data->tex_offset.y, data->tex_num);
 			}
-			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 		}
 
-		if (cmd->m_tex_update.bit && ctx->m_game_texture) {
-			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, ctx->m_pixel_buffer);
-			glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, cmd->m_tex_update.size.x * cmd->m_tex_update.size.y * cmd->m_tex_update.bit, cmd->m_tex_buffer);
-			ctx->m_game_texture->fill(0, cmd->m_tex_update.size.x, cmd->m_tex_update.size.y);
-			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		if (cmd->m_tex_update.region_count && ctx->m_game_texture) {
+			state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, ctx->m_pixel_buffer);
+			glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, cmd->m_tex_update.data_size, cmd->m_tex_buffer);
+			for (uint32_t i = 0; i < cmd->m_tex_update.region_count; i++) {
+				const auto region = &cmd->m_tex_update.regions[i];
+				ctx->m_game_texture->fill((uint8_t*)region->offset, region->size.x, region->size.y, region->pos.x, region->pos.y);
+			}
+			state.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 		}
 
 		Vertex::bindingDescription();
@@ -393,7 +449,7 @@ void Context::renderThread(void* context)
 			switch (command->type) {
 				case CommandType::UBOUpdate: {
 					const auto data = &cmd->m_ubo_update_queue.data[command->index];
-					ctx->m_game_color_ubo->updateData(data->type == UBOType::Gamma ? "gamma" : "palette", data->value);
+					ctx->m_game_color_ubo->updateData(ctx->m_game_color_vars[(int)data->type], data->value);
 				} break;
 				case CommandType::SetBlendState:
 					ctx->bindPipeline(ctx->m_game_pipeline, command->index);
@@ -403,41 +459,7 @@ void Context::renderThread(void* context)
 						glDrawElementsBaseVertex(GL_TRIANGLES, command->draw.count, GL_UNSIGNED_INT, 0, command->draw.start);
 					break;
 				case CommandType::PreFx:
-					ctx->m_prefx_texture->fillFromBuffer(ctx->m_game_framebuffer);
-					ctx->bindPipeline(ctx->m_prefx_pipeline);
-
-					if (App.bloom.active) {
-						ctx->bindFrameBuffer(ctx->m_bloom_framebuffer, false);
-						ctx->setViewport(ctx->m_bloom_tex_size);
-						ctx->drawQuad();
-
-						if (App.gl_caps.compute_shader) {
-							ctx->m_bloom_texture->fillFromBuffer(ctx->m_bloom_framebuffer);
-							ctx->m_blur_compute_pipeline->dispatchCompute(0, ctx->m_bloom_work_size, GL_PIXEL_BUFFER_BARRIER_BIT);
-							ctx->m_bloom_texture->fillFromBuffer(ctx->m_bloom_framebuffer);
-							ctx->m_blur_compute_pipeline->dispatchCompute(1, ctx->m_bloom_work_size, GL_PIXEL_BUFFER_BARRIER_BIT);
-							ctx->m_bloom_texture->fillFromBuffer(ctx->m_bloom_framebuffer);
-							ctx->m_blur_compute_pipeline->dispatchCompute(0, ctx->m_bloom_work_size, GL_PIXEL_BUFFER_BARRIER_BIT);
-							ctx->m_bloom_texture->fillFromBuffer(ctx->m_bloom_framebuffer);
-							ctx->m_blur_compute_pipeline->dispatchCompute(1, ctx->m_bloom_work_size, GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-						} else {
-							ctx->m_bloom_texture->fillFromBuffer(ctx->m_bloom_framebuffer);
-							ctx->drawQuad(1);
-							ctx->m_bloom_texture->fillFromBuffer(ctx->m_bloom_framebuffer);
-							ctx->drawQuad(2);
-							ctx->m_bloom_texture->fillFromBuffer(ctx->m_bloom_framebuffer);
-							ctx->drawQuad(1);
-							ctx->m_bloom_texture->fillFromBuffer(ctx->m_bloom_framebuffer);
-							ctx->drawQuad(2);
-						}
-
-						ctx->bindFrameBuffer(ctx->m_game_framebuffer, false);
-						ctx->setViewport(cmd->m_game_size);
-						ctx->bindPipeline(ctx->m_prefx_pipeline);
-						FrameBuffer::setDrawBuffers(1);
-					}
-					ctx->drawQuad(3 + App.bloom.active, 0, App.lut.selected);
-
+					ctx->renderPreFx();
 					ctx->bindPipeline(ctx->m_game_pipeline, command->index);
 					FrameBuffer::setDrawBuffers(ctx->m_game_framebuffer->getAttachmentCount());
 					break;
@@ -455,19 +477,20 @@ void Context::renderThread(void* context)
 						ctx->bindPipeline(ctx->m_movie_pipeline);
 						ctx->drawQuad();
 					} else {
-						if (App.sharpen.active) {
+						if (ctx->m_quality.sharpen) {
 							const auto sharpen_data = glm::vec3(App.sharpen.strength.value, App.sharpen.clamp.value, App.sharpen.radius.value);
 							if (ctx->m_sharpen_data != sharpen_data) {
-								ctx->m_postfx_ubo->updateDataVec4f("sharpen", glm::vec4(sharpen_data, 1.0f));
+								const auto sharpen_value = glm::vec4(sharpen_data, 1.0f);
+								ctx->m_postfx_ubo->updateData(ctx->m_sharpen_var, &sharpen_value);
 								ctx->m_sharpen_data = sharpen_data;
 							}
 						}
 
 						if (ISGLIDE3X()) {
-							if (App.bloom.active) {
+							if (ctx->m_quality.bloom) {
 								const auto bloom_data = glm::vec2(App.bloom.exposure.value, App.bloom.gamma.value);
 								if (ctx->m_bloom_data != bloom_data) {
-									ctx->m_bloom_ubo->updateDataVec2f("bloom", bloom_data);
+									ctx->m_bloom_ubo->updateData(ctx->m_bloom_var, &bloom_data);
 									ctx->m_bloom_data = bloom_data;
 								}
 							}
@@ -476,32 +499,7 @@ void Context::renderThread(void* context)
 							ctx->drawQuad();
 						}
 
-						if (App.sharpen.active || App.fxaa.active)
-							Upscaler::Instance().process(ctx->m_game_framebuffer, vp_size, vp_offset, ctx->m_postfx_framebuffer);
-						else
-							Upscaler::Instance().process(ctx->m_game_framebuffer, vp_size, vp_offset);
-
-						if (App.sharpen.active) {
-							if (App.fxaa.active)
-								ctx->m_postfx_texture->fillFromBuffer(ctx->m_postfx_framebuffer);
-							else {
-								ctx->bindDefaultFrameBuffer();
-								ctx->setViewport(vp_size, vp_offset);
-							}
-							ctx->bindPipeline(ctx->m_postfx_pipeline);
-							ctx->drawQuad(App.fxaa.active);
-						}
-
-						if (App.fxaa.active) {
-							if (App.gl_caps.compute_shader) {
-								ctx->m_postfx_texture->fillFromBuffer(ctx->m_postfx_framebuffer);
-								ctx->m_fxaa_compute_pipeline->dispatchCompute(App.fxaa.presets.selected, ctx->m_fxaa_work_size, GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
-							}
-							ctx->bindDefaultFrameBuffer();
-							ctx->setViewport(vp_size, vp_offset);
-							ctx->bindPipeline(ctx->m_postfx_pipeline);
-							ctx->drawQuad(2 + App.gl_caps.compute_shader, App.fxaa.presets.selected);
-						}
+						ctx->renderPostFx(vp_size, vp_offset);
 					}
 					break;
 				case CommandType::TakeScreenShot:
@@ -510,27 +508,54 @@ void Context::renderThread(void* context)
 			}
 		}
 
-		if (cmd->m_vertex_mod_count) {
-			glBufferSubData(GL_ARRAY_BUFFER, 0, cmd->m_vertex_mod_count * sizeof(VertexMod), ctx->m_vertices_mod.data[frame_index].data());
+		if (cmd->m_instance_mod_count) {
+			state.bindVertexArray(ctx->m_instance_array);
+			state.bindBuffer(GL_ARRAY_BUFFER, ctx->m_instance_buffer);
+			glBufferSubData(GL_ARRAY_BUFFER, 0, cmd->m_instance_mod_count * sizeof(InstanceMod), ctx->m_instances_mod.data[frame_index].data());
 
 			ctx->bindPipeline(ctx->m_mod_pipeline);
 			if (cmd->m_hd_text_mask.active) {
-				ctx->m_mod_pipeline->setUniformVec4f("u_TextMask", cmd->m_hd_text_mask.metrics);
-				ctx->m_mod_pipeline->setUniform1i("u_IsMasking", cmd->m_hd_text_mask.masking);
+				ctx->m_mod_pipeline->setUniformVec4f(ctx->m_text_mask_uniform, cmd->m_hd_text_mask.metrics);
+				ctx->m_mod_pipeline->setUniform1i(ctx->m_is_masking_uniform, cmd->m_hd_text_mask.masking);
 				cmd->m_hd_text_mask.active = false;
 			}
 
-			VertexMod::bindingDescription();
-			glDrawElements(GL_TRIANGLES, cmd->m_vertex_mod_count / 4 * 6, GL_UNSIGNED_INT, 0);
+			glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, cmd->m_instance_mod_count);
+
+			state.bindVertexArray(ctx->m_vertex_array);
+			state.bindBuffer(GL_ARRAY_BUFFER, ctx->m_vertex_buffer);
 		}
+		ScreenCapture::Instance().captureFrame();
 
 		GLsync sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 		glFlush();
 		glClientWaitSync(sync, 0, GL_TIMEOUT_IGNORED);
 		glDeleteSync(sync);
 
+		if (App.governor.active || App.dynamic_resolution.active) {
+			LARGE_INTEGER render_end;
+			QueryPerformanceCounter(&render_end);
+			const double render_ms = double(render_end.QuadPart - render_start.QuadPart) / ctx->m_frame.frequency;
+
+			if (App.governor.active) {
+				FrameGovernorParams governor_params;
+				governor_params.budget_ms = 1000.0 / App.governor.target_fps.value;
+				ctx->m_governor.update(render_ms, governor_params);
+			}
+			if (App.dynamic_resolution.active) {
+				DynamicResolutionParams resolution_params;
+				resolution_params.budget_ms = 1000.0 / App.governor.target_fps.value;
+				resolution_params.min_scale = App.dynamic_resolution.min_scale.value;
+				ctx->m_resolution.update(render_ms, resolution_params);
+			}
+		}
+
 		ReleaseSemaphore(ctx->m_semaphore_gpu[frame_index], 1, NULL);
 		Menu::instance().draw();
+		state.endFrame();
+		state.invalidate();
+		ResourcePool::Instance().endFrame();
+		ScreenCapture::Instance().update();
 		SwapBuffers(App.hdc);
 
 		if (ctx->m_limiter.active) {
@@ -574,7 +599,7 @@ void Context::onResize(glm::uvec2 w_size, glm::uvec2 g_size, uint32_t bpp)
 			};
 		else
 			frambuffer_ci.attachments = { { TEXTURE_SLOT_GAME } };
-		m_game_framebuffer = Context::createFrameBuffer(frambuffer_ci);
+		ResourcePool::Instance().acquire(m_game_framebuffer, frambuffer_ci);
 
 		if (ISGLIDE3X()) {
 			m_game_pipeline->setUniformMat4f("u_MVP", mvp);
@@ -583,23 +608,12 @@ void Context::onResize(glm::uvec2 w_size, glm::uvec2 g_size, uint32_t bpp)
 			m_bloom_tex_size = { game_size.x / 4, game_size.y / 4 };
 			m_bloom_work_size = { ceil((float)m_bloom_tex_size.x / 16), ceil((float)m_bloom_tex_size.y / 16) };
 
-			FrameBufferCreateInfo bloom_frambuffer_ci;
-			bloom_frambuffer_ci.size = m_bloom_tex_size;
-			bloom_frambuffer_ci.attachments = { { TEXTURE_SLOT_BLOOM1, {}, { GL_LINEAR, GL_LINEAR } } };
-			m_bloom_framebuffer = Context::createFrameBuffer(bloom_frambuffer_ci);
-			if (App.gl_caps.compute_shader)
-				m_bloom_framebuffer->getTexture()->bindImage(IMAGE_UNIT_BLUR);
-
-			TextureCreateInfo bloom_texture_ci;
-			bloom_texture_ci.size = m_bloom_tex_size;
-			bloom_texture_ci.slot = TEXTURE_SLOT_BLOOM2;
-			bloom_texture_ci.filter = { GL_LINEAR, GL_LINEAR };
-			m_bloom_texture = Context::createTexture(bloom_texture_ci);
-
+			// Swapped with the game frame buffer texture each frame, so it has to match it.
 			TextureCreateInfo prefx_texture_ci;
 			prefx_texture_ci.size = game_size;
 			prefx_texture_ci.slot = TEXTURE_SLOT_PREFX;
-			m_prefx_texture = Context::createTexture(prefx_texture_ci);
+			prefx_texture_ci.filter = { GL_LINEAR, GL_LINEAR };
+			ResourcePool::Instance().acquire(m_prefx_texture, prefx_texture_ci);
 		} else {
 			TextureCreateInfo texture_ci;
 			texture_ci.size = game_size;
@@ -608,7 +622,7 @@ void Context::onResize(glm::uvec2 w_size, glm::uvec2 g_size, uint32_t bpp)
 			else
 				texture_ci.format = { GL_RGBA8, GL_BGRA };
 			texture_ci.filter = { GL_LINEAR, GL_LINEAR };
-			m_game_texture = Context::createTexture(texture_ci);
+			ResourcePool::Instance().acquire(m_game_texture, texture_ci);
 		}
 	}
 
@@ -620,21 +634,15 @@ void Context::onResize(glm::uvec2 w_size, glm::uvec2 g_size, uint32_t bpp)
 	}
 
 	if (game_resized || window_resized) {
-		FrameBufferCreateInfo frambuffer_ci;
-		frambuffer_ci.size = App.viewport.size;
-		frambuffer_ci.attachments = { { TEXTURE_SLOT_POSTFX1, {}, { GL_LINEAR, GL_LINEAR } } };
-		m_postfx_framebuffer = Context::createFrameBuffer(frambuffer_ci);
-		if (App.gl_caps.compute_shader)
-			m_postfx_framebuffer->getTexture()->bindImage(IMAGE_UNIT_FXAA);
+		// Targets are acquired again on first use, so only the ones still needed come back.
+		for (auto& target : m_render_targets)
+			ResourcePool::Instance().release(target.frame_buffer);
+		m_render_targets.clear();
+		m_prefx_chain.signature = 0;
+		m_postfx_chain.signature = 0;
 
 		m_fxaa_work_size = { ceil((float)App.viewport.size.x / 16), ceil((float)App.viewport.size.y / 16) };
 
-		TextureCreateInfo texture_ci;
-		texture_ci.size = App.viewport.size;
-		texture_ci.slot = TEXTURE_SLOT_POSTFX2;
-		texture_ci.filter = { GL_LINEAR, GL_LINEAR };
-		m_postfx_texture = Context::createTexture(texture_ci);
-
 		onShaderChange();
 	}
 
@@ -651,15 +659,324 @@ void Context::onResize(glm::uvec2 w_size, glm::uvec2 g_size, uint32_t bpp)
 
 void Context::onShaderChange()
 {
+	// A resize keeps the loaded preset, including the governor's fallback one.
 	if (m_current_shader != App.shader.selected) {
 		if (!Upscaler::Instance().loadPreset())
 			Upscaler::Instance().loadDefaultPreset();
+		m_upscaler_fallback = false;
+		m_upscaler_fallback_failed = false;
 	}
 
 	Upscaler::Instance().setupPasses();
 	m_current_shader = App.shader.selected;
 }
 
+void Context::updateQuality()
+{
+	QualityStep steps[MAX_QUALITY_STEPS];
+	uint32_t step_count = 0;
+	uint32_t signature = 0;
+
+	if (App.governor.active) {
+		if (App.fxaa.active && App.fxaa.presets.selected > 0)
+			steps[step_count++] = QualityStep::FxaaLow;
+		if (App.sharpen.active)
+			steps[step_count++] = QualityStep::SharpenOff;
+		if (App.fxaa.active)
+			steps[step_count++] = QualityStep::FxaaOff;
+		if (ISGLIDE3X() && App.bloom.active)
+			steps[step_count++] = QualityStep::BloomOff;
+		if (!m_upscaler_fallback_failed && !App.shader.presets.items.empty() && App.shader.presets.items[App.shader.selected].value != UPSCALER_DEFAULT_PRESET)
+			steps[step_count++] = QualityStep::UpscalerFallback;
+
+		for (uint32_t i = 0; i < step_count; i++)
+			signature |= 1 << (uint32_t)steps[i];
+		signature |= (App.shader.selected + 1) << MAX_QUALITY_STEPS;
+	}
+
+	if (signature != m_quality_signature) {
+		m_governor.reset(step_count);
+		m_quality_signature = signature;
+	}
+
+	m_quality = { App.sharpen.active, App.fxaa.active, App.fxaa.presets.selected, App.bloom.active };
+	bool upscaler_fallback = false;
+
+	for (uint32_t i = 0; i < m_governor.getLevel(); i++) {
+		switch (steps[i]) {
+			case QualityStep::FxaaLow: m_quality.fxaa_preset = 0; break;
+			case QualityStep::SharpenOff: m_quality.sharpen = false; break;
+			case QualityStep::FxaaOff: m_quality.fxaa = false; break;
+			case QualityStep::BloomOff: m_quality.bloom = false; break;
+			case QualityStep::UpscalerFallback: upscaler_fallback = true; break;
+		}
+	}
+	App.governor.level = m_governor.getLevel();
+	m_bloom_active = m_quality.bloom;
+
+	if (upscaler_fallback != m_upscaler_fallback) {
+		if (upscaler_fallback && Upscaler::Instance().loadPreset(UPSCALER_DEFAULT_PRESET)) {
+			Upscaler::Instance().setupPasses();
+			m_upscaler_fallback = true;
+		} else {
+			// Without the fallback preset the last step does nothing, the governor stops below it.
+			if (upscaler_fallback) {
+				m_governor.setMaxLevel(step_count - 1);
+				m_quality_signature &= ~(1 << (uint32_t)QualityStep::UpscalerFallback);
+				App.governor.level = m_governor.getLevel();
+			}
+			m_current_shader = -1;
+			onShaderChange();
+			m_upscaler_fallback_failed = upscaler_fallback;
+		}
+	}
+
+	if (!App.dynamic_resolution.active)
+		m_resolution.reset();
+
+	// The upscaler keeps full resolution for presets that cannot scale, show what is in effect.
+	Upscaler::Instance().setRenderScale((float)m_resolution.getScale());
+	App.dynamic_resolution.scale = Upscaler::Instance().getRenderScale();
+}
+
+void Context::buildPreFxChain()
+{
+	auto& graph = m_prefx_chain.graph;
+	graph.clear();
+
+	const uint32_t scene = graph.importTarget((uint32_t)PostTarget::Scene);
+	const uint32_t game = graph.importTarget((uint32_t)PostTarget::Game);
+
+	if (m_quality.bloom) {
+		const RenderTargetDesc desc = { m_bloom_tex_size.x, m_bloom_tex_size.y, GL_RGBA8 };
+		uint32_t bloom = graph.createTarget(desc);
+		graph.addPass((uint32_t)PostPass::BloomExtract, { scene }, bloom);
+
+		for (uint32_t i = 0; i < 4; i++) {
+			const uint32_t blurred = graph.createTarget(desc);
+			graph.addPass((uint32_t)(i % 2 ? PostPass::BlurV : PostPass::BlurH), { bloom }, blurred);
+			bloom = blurred;
+		}
+		graph.addPass((uint32_t)PostPass::Composite, { scene, bloom }, game);
+	} else
+		graph.addPass((uint32_t)PostPass::Composite, { scene }, game);
+
+	if (!graph.compile())
+		error_log("Pre-fx render graph is not valid!");
+
+	allocateTargets(m_prefx_chain);
+}
+
+void Context::buildPostFxChain()
+{
+	auto& graph = m_postfx_chain.graph;
+	graph.clear();
+
+	const uint32_t game = graph.importTarget((uint32_t)PostTarget::Game);
+	const uint32_t screen = graph.importTarget((uint32_t)PostTarget::Screen);
+	const RenderTargetDesc desc = { App.viewport.size.x, App.viewport.size.y, GL_RGBA8 };
+
+	uint32_t image = m_quality.sharpen || m_quality.fxaa ? graph.createTarget(desc) : screen;
+	graph.addPass((uint32_t)PostPass::Upscale, { game }, image);
+
+	if (m_quality.sharpen) {
+		const uint32_t output = m_quality.fxaa ? graph.createTarget(desc) : screen;
+		graph.addPass((uint32_t)PostPass::Sharpen, { image }, output);
+		image = output;
+	}
+
+	if (m_quality.fxaa) {
+		// Compute fxaa can only write an image, a copy pass takes it to the screen.
+		const uint32_t output = App.gl_caps.compute_shader ? graph.createTarget(desc) : screen;
+		graph.addPass((uint32_t)PostPass::Fxaa, { image }, output);
+		if (output != screen)
+			graph.addPass((uint32_t)PostPass::Present, { output }, screen);
+	}
+
+	if (!graph.compile())
+		error_log("Post-fx render graph is not valid!");
+
+	allocateTargets(m_postfx_chain);
+}
+
+void Context::allocateTargets(PostChain& chain)
+{
+	const auto& other_targets = (&chain == &m_prefx_chain ? m_postfx_chain : m_prefx_chain).targets;
+	auto isUsed = [&](uint32_t index) {
+		return std::find(other_targets.begin(), other_targets.end(), index) != other_targets.end() || std::find(chain.targets.begin(), chain.targets.end(), index) != chain.targets.end();
+	};
+
+	chain.targets.clear();
+	for (auto& physical : chain.graph.getPhysicalTargets()) {
+		uint32_t target_index = RENDER_GRAPH_NONE;
+		if (!physical.imported) {
+			uint32_t match = 0;
+			for (uint32_t i = 0; i < m_render_targets.size() && target_index == RENDER_GRAPH_NONE; i++) {
+				if (m_render_targets[i].desc == physical.desc && match++ == physical.index)
+					target_index = i;
+			}
+
+			if (target_index == RENDER_GRAPH_NONE) {
+				// Slots past MAX_RENDER_TARGETS belong to the lut and others, once full a target no chain uses is resized.
+				if (m_render_targets.size() < MAX_RENDER_TARGETS) {
+					target_index = (uint32_t)m_render_targets.size();
+					m_render_targets.push_back({});
+				} else {
+					for (uint32_t i = 0; i < MAX_RENDER_TARGETS && target_index == RENDER_GRAPH_NONE; i++) {
+						if (!isUsed(i))
+							target_index = i;
+					}
+					if (target_index == RENDER_GRAPH_NONE) {
+						error_log("Render graph needs more than %d render targets!", MAX_RENDER_TARGETS);
+						chain.targets.push_back(RENDER_GRAPH_NONE);
+						continue;
+					}
+				}
+
+				FrameBufferCreateInfo frambuffer_ci;
+				frambuffer_ci.size = { physical.desc.width, physical.desc.height };
+				frambuffer_ci.attachments = { { TEXTURE_SLOT_TARGET + target_index, {}, { GL_LINEAR, GL_LINEAR }, { (GLint)physical.desc.format, GL_RGBA } } };
+				m_render_targets[target_index].desc = physical.desc;
+				ResourcePool::Instance().acquire(m_render_targets[target_index].frame_buffer, frambuffer_ci);
+			}
+		}
+		chain.targets.push_back(target_index);
+	}
+}
+
+Texture* Context::getTargetTexture(const PostChain& chain, uint32_t physical)
+{
+	if (chain.targets[physical] != RENDER_GRAPH_NONE)
+		return m_render_targets[chain.targets[physical]].frame_buffer->getTexture();
+
+	switch ((PostTarget)chain.graph.getPhysicalTargets()[physical].external) {
+		case PostTarget::Scene: return m_prefx_texture.get();
+		case PostTarget::Game: return m_game_framebuffer->getTexture();
+	}
+	return nullptr;
+}
+
+void Context::bindTarget(const PostChain& chain, uint32_t physical, glm::ivec2 vp_size, glm::ivec2 vp_offset)
+{
+	if (chain.targets[physical] != RENDER_GRAPH_NONE) {
+		const auto& frame_buffer = m_render_targets[chain.targets[physical]].frame_buffer;
+		bindFrameBuffer(frame_buffer, false);
+		setViewport(glm::uvec2(frame_buffer->getWidth(), frame_buffer->getHeight()));
+		return;
+	}
+
+	switch ((PostTarget)chain.graph.getPhysicalTargets()[physical].external) {
+		case PostTarget::Game:
+			bindFrameBuffer(m_game_framebuffer, false);
+			setViewport(glm::uvec2(m_game_framebuffer->getWidth(), m_game_framebuffer->getHeight()));
+			break;
+		case PostTarget::Screen:
+			bindDefaultFrameBuffer();
+			setViewport(vp_size, vp_offset);
+			break;
+	}
+}
+
+void Context::bindInput(const PostChain& chain, uint32_t physical, const std::unique_ptr<Pipeline>& pipeline, UniformHandle sampler)
+{
+	Texture* texture = getTargetTexture(chain, physical);
+	pipeline->setUniform1i(sampler, texture->getSlot());
+	texture->bind();
+}
+
+void Context::renderPreFx()
+{
+	const uint32_t signature = 1 | m_quality.bloom << 1;
+	if (m_prefx_chain.signature != signature) {
+		buildPreFxChain();
+		m_prefx_chain.signature = signature;
+	}
+
+	// The scene moves out of the game frame buffer instead of being copied, the composite fills it again.
+	m_game_framebuffer->swapTexture(0, m_prefx_texture);
+
+	const auto& chain = m_prefx_chain;
+	for (auto& pass : chain.graph.getPasses()) {
+		switch ((PostPass)pass.id) {
+			case PostPass::BloomExtract:
+				bindTarget(chain, pass.output);
+				bindPipeline(m_prefx_pipeline);
+				bindInput(chain, pass.inputs[0], m_prefx_pipeline, m_prefx_texture_uniform);
+				drawQuad();
+				break;
+			case PostPass::BlurH:
+			case PostPass::BlurV:
+				if (App.gl_caps.compute_shader) {
+					bindPipeline(m_blur_compute_pipeline);
+					bindInput(chain, pass.inputs[0], m_blur_compute_pipeline, m_blur_input_uniform);
+					getTargetTexture(chain, pass.output)->bindImage(IMAGE_UNIT_BLUR);
+					m_blur_compute_pipeline->dispatchCompute(pass.id == (uint32_t)PostPass::BlurV, m_bloom_work_size, GL_TEXTURE_FETCH_BARRIER_BIT);
+				} else {
+					bindTarget(chain, pass.output);
+					bindPipeline(m_prefx_pipeline);
+					bindInput(chain, pass.inputs[0], m_prefx_pipeline, m_bloom_input_uniform);
+					drawQuad(pass.id == (uint32_t)PostPass::BlurH ? 1 : 2);
+				}
+				break;
+			case PostPass::Composite:
+				bindTarget(chain, pass.output);
+				bindPipeline(m_prefx_pipeline);
+				FrameBuffer::setDrawBuffers(1);
+				bindInput(chain, pass.inputs[0], m_prefx_pipeline, m_prefx_texture_uniform);
+				if (pass.inputs.size() > 1)
+					bindInput(chain, pass.inputs[1], m_prefx_pipeline, m_bloom_uniform);
+				drawQuad(3 + (pass.inputs.size() > 1), 0, App.lut.selected);
+				break;
+		}
+	}
+}
+
+void Context::renderPostFx(glm::ivec2 vp_size, glm::ivec2 vp_offset)
+{
+	const uint32_t signature = 1 | m_quality.sharpen << 1 | m_quality.fxaa << 2;
+	if (m_postfx_chain.signature != signature) {
+		buildPostFxChain();
+		m_postfx_chain.signature = signature;
+	}
+
+	const auto& chain = m_postfx_chain;
+	for (auto& pass : chain.graph.getPasses()) {
+		switch ((PostPass)pass.id) {
+			case PostPass::Upscale:
+				if (chain.targets[pass.output] != RENDER_GRAPH_NONE)
+					Upscaler::Instance().process(m_game_framebuffer, vp_size, vp_offset, m_render_targets[chain.targets[pass.output]].frame_buffer);
+				else
+					Upscaler::Instance().process(m_game_framebuffer, vp_size, vp_offset);
+				break;
+			case PostPass::Sharpen:
+				bindTarget(chain, pass.output, vp_size, vp_offset);
+				bindPipeline(m_postfx_pipeline);
+				bindInput(chain, pass.inputs[0], m_postfx_pipeline, m_postfx_input_uniform);
+				drawQuad(0);
+				break;
+			case PostPass::Fxaa:
+				if (App.gl_caps.compute_shader) {
+					bindPipeline(m_fxaa_compute_pipeline);
+					bindInput(chain, pass.inputs[0], m_fxaa_compute_pipeline, m_fxaa_input_uniform);
+					getTargetTexture(chain, pass.output)->bindImage(IMAGE_UNIT_FXAA);
+					m_fxaa_compute_pipeline->dispatchCompute(m_quality.fxaa_preset, m_fxaa_work_size, GL_TEXTURE_FETCH_BARRIER_BIT);
+				} else {
+					bindTarget(chain, pass.output, vp_size, vp_offset);
+					bindPipeline(m_postfx_pipeline);
+					bindInput(chain, pass.inputs[0], m_postfx_pipeline, m_postfx_input_uniform);
+					drawQuad(2, m_quality.fxaa_preset);
+				}
+				break;
+			case PostPass::Present:
+				bindTarget(chain, pass.output, vp_size, vp_offset);
+				bindPipeline(m_postfx_pipeline);
+				bindInput(chain, pass.inputs[0], m_postfx_pipeline, m_postfx_input_uniform);
+				drawQuad(3);
+				break;
+		}
+	}
+}
+
 void Context::onStageChange()
 {
 	if (App.game.screen == GameScreen::Movie)
@@ -669,7 +986,7 @@ void Context::onStageChange()
 		case DrawStage::World:
 			break;
 		case DrawStage::UI:
-			if (ISGLIDE3X() && (App.bloom.active || App.lut.selected) && *d2::screen_shift != SCREENPANEL_BOTH) {
+			if (ISGLIDE3X() && (m_bloom_active || App.lut.selected) && *d2::screen_shift != SCREENPANEL_BOTH) {
 				flushVertices();
 				m_command_buffer[m_frame_index].pushCommand(CommandType::PreFx, m_current_blend_index);
 			}
@@ -726,12 +1043,12 @@ void Context::beginFrame()
 	m_vertices.count = m_vertices.start = 0;
 	m_vertices.ptr = m_vertices.data[m_frame_index].data();
 
-	m_vertices_mod.count = 0;
-	m_vertices_mod.ptr = m_vertices_mod.data[m_frame_index].data();
+	m_instances_mod.count = 0;
+	m_instances_mod.ptr = m_instances_mod.data[m_frame_index].data();
 
 	m_delay_push = false;
-	m_vertices_late.count = 0;
-	m_vertices_late.ptr = m_vertices_late.data[0].data();
+	m_instances_late.count = 0;
+	m_instances_late.ptr = m_instances_late.data[0].data();
 
 	m_frame.vertex_count = 0;
 	m_frame.drawcall_count = 0;
@@ -758,8 +1075,8 @@ void Context::presentFrame()
 
 	modules::HDText::Instance().update();
 
-	if (m_vertices_mod.count) {
-		m_command_buffer[m_frame_index].m_vertex_mod_count = m_vertices_mod.count;
+	if (m_instances_mod.count) {
+		m_command_buffer[m_frame_index].m_instance_mod_count = m_instances_mod.count;
 		m_frame.drawcall_count++;
 	}
 	Menu::instance().check();
@@ -785,13 +1102,7 @@ void Context::presentFrame()
 
 void Context::setViewport(glm::ivec2 size, glm::ivec2 offset)
 {
-	static glm::ivec4 viewport_metrics = { 0, 0, 0, 0 };
-	const auto metrics = glm::ivec4(size, offset);
-	if (viewport_metrics == metrics)
-		return;
-
-	glViewport(offset.x, offset.y, size.x, size.y);
-	viewport_metrics = metrics;
+	GLState::Instance().setViewport(size, offset);
 }
 
 void Context::pushVertex(const GlideVertex* vertex, glm::vec2 fix, glm::ivec2 offset)
@@ -848,35 +1159,53 @@ void Context::drawQuad(int8_t flag_x, int8_t flag_y, int16_t tex_id)
 
 void Context::pushObject(const std::unique_ptr<Object>& object)
 {
-	const auto vertices = object->getVertices();
+	const auto instance = object->getInstance();
 
 	if (m_delay_push) {
-		memcpy(m_vertices_late.ptr, vertices, sizeof(VertexMod) * 4);
+		*m_instances_late.ptr = *instance;
 
-		m_vertices_late.ptr += 4;
-		m_vertices_late.count += 4;
+		m_instances_late.ptr++;
+		m_instances_late.count++;
 	} else {
-		memcpy(m_vertices_mod.ptr, vertices, sizeof(VertexMod) * 4);
+		*m_instances_mod.ptr = *instance;
 
-		m_vertices_mod.ptr += 4;
-		m_vertices_mod.count += 4;
+		m_instances_mod.ptr++;
+		m_instances_mod.count++;
 	}
 	m_frame.vertex_count += 4;
 }
 
+void Context::pushInstances(const InstanceMod* instances, uint32_t count, glm::vec2 offset)
+{
+	InstanceMod* ptr = m_delay_push ? m_instances_late.ptr : m_instances_mod.ptr;
+	memcpy(ptr, instances, sizeof(InstanceMod) * count);
+
+	for (uint32_t i = 0; i < count; i++)
+		ptr[i].position += offset;
+
+	if (m_delay_push) {
+		m_instances_late.ptr += count;
+		m_instances_late.count += count;
+	} else {
+		m_instances_mod.ptr += count;
+		m_instances_mod.count += count;
+	}
+	m_frame.vertex_count += count * 4;
+}
+
 void Context::appendDelayedObjects()
 {
-	if (m_vertices_late.count == 0)
+	if (m_instances_late.count == 0)
 		return;
 
-	memcpy(m_vertices_mod.ptr, m_vertices_late.data[0].data(), m_vertices_late.count * sizeof(VertexMod));
+	memcpy(m_instances_mod.ptr, m_instances_late.data[0].data(), m_instances_late.count * sizeof(InstanceMod));
 
-	m_vertices_mod.count += m_vertices_late.count;
-	m_vertices_mod.ptr += m_vertices_late.count;
+	m_instances_mod.count += m_instances_late.count;
+	m_instances_mod.ptr += m_instances_late.count;
 
 	m_delay_push = false;
-	m_vertices_late.count = 0;
-	m_vertices_late.ptr = m_vertices_late.data[0].data();
+	m_instances_late.count = 0;
+	m_instances_late.ptr = m_instances_late.data[0].data();
 }
 
 void Context::toggleVsync()
@@ -904,21 +1233,7 @@ void Context::resetFileTime()
 
 void Context::takeScreenShot()
 {
-	const uint32_t tickCount = GetTickCount();
-
-	if (ssTickCount > tickCount - 1000)
-		return;
-
-	uint8_t* data = new GLubyte[App.viewport.size.x * App.viewport.size.y * 3];
-	memset(data, 0, App.viewport.size.x * App.viewport.size.y * 3);
-
-	glPixelStorei(GL_PACK_ALIGNMENT, 1);
-	glReadPixels(App.viewport.offset.x, App.viewport.offset.y, App.viewport.size.x, App.viewport.size.y, GL_RGB, GL_UNSIGNED_BYTE, data);
-
-	std::string file_name = helpers::saveScreenShot(data, App.viewport.size.x, App.viewport.size.y);
-	delete[] data;
-
-	ssTickCount = tickCount;
+	ScreenCapture::Instance().takeScreenShot();
 }
 
 void Context::imguiInit()
@@ -950,6 +1265,19 @@ void Context::imguiRender()
 
 void APIENTRY Context::debugMessageCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* data)
 {
+	// Drivers repeat the same message every frame, only the first few of each message are reported.
+	// Ids are only unique per source and type. High severity messages are always reported.
+	static std::mutex counts_mutex;
+	static std::map<std::tuple<GLenum, GLenum, GLuint>, uint32_t> message_counts;
+	uint32_t count = 0;
+	{
+		std::lock_guard<std::mutex> lock(counts_mutex);
+		count = ++message_counts[{ source, type, id }];
+	}
+	const bool limited = severity != GL_DEBUG_SEVERITY_HIGH;
+	if (limited && count > GL_DEBUG_REPEAT_LIMIT)
+		return;
+
 	const char* source_str;
 	const char* severity_str;
 
@@ -988,8 +1316,11 @@ void APIENTRY Context::debugMessageCallback(GLenum source, GLenum type, GLuint i
 	logTrace(C_GRAY, true, "%s", source_str);
 	trace("%s", message);
 
-	if (App.log)
+	if (App.log) {
 		logFileWrite(0, "OpenGL: [%u / %s]: %s | %s", id, severity_str, source_str, message);
+		if (limited && count == GL_DEBUG_REPEAT_LIMIT)
+			logFileWrite(2, "OpenGL: [%u / %s] reported %u times, further reports suppressed.", id, source_str, count);
+	}
 }
 
 }
\ No newline at end of file
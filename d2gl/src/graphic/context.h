@@ -23,8 +23,10 @@
 
 #include "command_buffer.h"
 #include "frame_buffer.h"
+#include "frame_governor.h"
 #include "object.h"
 #include "pipeline.h"
+#include "render_graph.h"
 #include "texture.h"
 #include "uniform_buffer.h"
 
@@ -33,17 +35,19 @@ namespace d2gl {
 #define MAX_FRAME_LATENCY 6
 #define MAX_INDICES 6 * 50000
 #define MAX_VERTICES 4 * 50000
-#define MAX_VERTICES_MOD 4 * 20000
+#define MAX_INSTANCES_MOD 20000
 #define PIXEL_BUFFER_SIZE 12 * 1024 * 1024
 #define MAX_FRAMETIME_SAMPLE_COUNT 120
+#define MAX_QUALITY_STEPS 5
+#define GL_DEBUG_REPEAT_LIMIT 10
 
 #define TEXTURE_SLOT_DEFAULT 0
 #define TEXTURE_SLOT_GAME 1
-#define TEXTURE_SLOT_POSTFX1 2
-#define TEXTURE_SLOT_POSTFX2 3
-#define TEXTURE_SLOT_PREFX 4
-#define TEXTURE_SLOT_BLOOM1 5
-#define TEXTURE_SLOT_BLOOM2 6
+#define TEXTURE_SLOT_PREFX 2
+#define TEXTURE_SLOT_TARGET 3
+
+// Render targets take slots 3 to 10, the pre-fx and post-fx graphs need 4 at most.
+#define MAX_RENDER_TARGETS 8
 
 #define TEXTURE_SLOT_LUT 11
 #define TEXTURE_SLOT_CURSOR 12
@@ -79,6 +83,49 @@ struct SharpenData {
 	float radius = 1.0f;
 };
 
+enum class QualityStep {
+	FxaaLow,
+	SharpenOff,
+	FxaaOff,
+	BloomOff,
+	UpscalerFallback,
+};
+
+struct RenderQuality {
+	bool sharpen = false;
+	bool fxaa = false;
+	int fxaa_preset = 0;
+	bool bloom = false;
+};
+
+enum class PostPass {
+	BloomExtract,
+	BlurH,
+	BlurV,
+	Composite,
+	Upscale,
+	Sharpen,
+	Fxaa,
+	Present,
+};
+
+enum class PostTarget {
+	Scene,
+	Game,
+	Screen,
+};
+
+struct RenderTarget {
+	RenderTargetDesc desc;
+	std::unique_ptr<FrameBuffer> frame_buffer;
+};
+
+struct PostChain {
+	RenderGraph graph;
+	std::vector<uint32_t> targets; // render target of each physical target, none for imported ones
+	uint32_t signature = 0;
+};
+
 struct FrameMetrics {
 	double frame_time = 0.0;
 	double prev_time = 0.0;
@@ -104,6 +151,7 @@ struct LimiterMetrics {
 struct GLCaps {
 	bool compute_shader = false;
 	bool independent_blending = false;
+	bool program_binary = false;
 };
 
 class Context {
@@ -117,19 +165,30 @@ class Context {
 	GLuint m_index_buffer;
 	GLuint m_vertex_array;
 	GLuint m_vertex_buffer;
+	GLuint m_instance_array;
+	GLuint m_instance_buffer;
 	uint32_t m_frame_index = 0;
 
 	bool m_delay_push = false;
 	Vertices<Vertex, MAX_VERTICES, MAX_FRAME_LATENCY> m_vertices;
-	Vertices<VertexMod, MAX_VERTICES_MOD, MAX_FRAME_LATENCY> m_vertices_mod;
-	Vertices<VertexMod, MAX_VERTICES_MOD, 1> m_vertices_late;
+	Vertices<InstanceMod, MAX_INSTANCES_MOD, MAX_FRAME_LATENCY> m_instances_mod;
+	Vertices<InstanceMod, MAX_INSTANCES_MOD, 1> m_instances_late;
 	VertexParams m_vertex_params;
 
 	FrameMetrics m_frame;
 	LimiterMetrics m_limiter;
 
+	FrameGovernor m_governor;
+	DynamicResolution m_resolution;
+	RenderQuality m_quality;
+	std::atomic<bool> m_bloom_active = false; // m_quality.bloom for the game thread
+	uint32_t m_quality_signature = 0;
+	bool m_upscaler_fallback = false;
+	bool m_upscaler_fallback_failed = false;
+
 	std::unique_ptr<Texture> m_game_texture;
 	std::unique_ptr<UniformBuffer> m_game_color_ubo;
+	UboHandle m_game_color_vars[2];
 	std::unique_ptr<Pipeline> m_game_pipeline;
 	std::unique_ptr<FrameBuffer> m_game_framebuffer;
 	std::unique_ptr<Pipeline> m_movie_pipeline;
@@ -137,12 +196,19 @@ class Context {
 	glm::vec3 m_sharpen_data;
 	glm::uvec2 m_fxaa_work_size = { 0, 0 };
 	std::unique_ptr<UniformBuffer> m_postfx_ubo;
-	std::unique_ptr<Texture> m_postfx_texture;
-	std::unique_ptr<FrameBuffer> m_postfx_framebuffer;
+	UboHandle m_sharpen_var;
 	std::unique_ptr<Pipeline> m_postfx_pipeline;
+	UniformHandle m_postfx_input_uniform;
 	std::unique_ptr<Pipeline> m_fxaa_compute_pipeline;
+	UniformHandle m_fxaa_input_uniform;
+
+	std::vector<RenderTarget> m_render_targets;
+	PostChain m_prefx_chain;
+	PostChain m_postfx_chain;
 
 	std::unique_ptr<Pipeline> m_mod_pipeline;
+	UniformHandle m_text_mask_uniform;
+	UniformHandle m_is_masking_uniform;
 	int m_current_shader = -1;
 
 	// Glide only
@@ -155,13 +221,16 @@ class Context {
 	glm::uvec2 m_bloom_tex_size = { 0, 0 };
 	glm::uvec2 m_bloom_work_size = { 0, 0 };
 	std::unique_ptr<UniformBuffer> m_bloom_ubo;
-	std::unique_ptr<Texture> m_bloom_texture;
-	std::unique_ptr<FrameBuffer> m_bloom_framebuffer;
+	UboHandle m_bloom_var;
 	std::unique_ptr<Pipeline> m_blur_compute_pipeline;
+	UniformHandle m_blur_input_uniform;
 
 	std::unique_ptr<Texture> m_lut_texture;
 	std::unique_ptr<Texture> m_prefx_texture;
 	std::unique_ptr<Pipeline> m_prefx_pipeline;
+	UniformHandle m_prefx_texture_uniform;
+	UniformHandle m_bloom_uniform;
+	UniformHandle m_bloom_input_uniform;
 
 public:
 	Context();
@@ -172,6 +241,7 @@ public:
 	void onResize(glm::uvec2 w_size, glm::uvec2 g_size, uint32_t bpp = 8);
 	void onShaderChange();
 	void onStageChange();
+	void updateQuality();
 	void setBlendState(uint32_t index);
 
 	void beginFrame();
@@ -191,6 +261,7 @@ public:
 
 	inline void toggleDelayPush(bool delay) { m_delay_push = delay; }
 	void pushObject(const std::unique_ptr<Object>& object);
+	void pushInstances(const InstanceMod* instances, uint32_t count, glm::vec2 offset);
 	void appendDelayedObjects();
 
 	inline void setVertexColor(uint32_t color) { m_vertex_params.color = color; }
@@ -211,7 +282,6 @@ public:
 	void toggleVsync();
 	void setFpsLimit(bool active, int max_fps);
 	void takeScreenShot();
-	uint32_t ssTickCount = 0;
 
 	void imguiStartFrame();
 	void imguiRender();
@@ -219,6 +289,15 @@ public:
 private:
 	void resetFileTime();
 
+	void buildPreFxChain();
+	void buildPostFxChain();
+	void allocateTargets(PostChain& chain);
+	void bindTarget(const PostChain& chain, uint32_t physical, glm::ivec2 vp_size = { 0, 0 }, glm::ivec2 vp_offset = { 0, 0 });
+	void bindInput(const PostChain& chain, uint32_t physical, const std::unique_ptr<Pipeline>& pipeline, UniformHandle sampler);
+	Texture* getTargetTexture(const PostChain& chain, uint32_t physical);
+	void renderPreFx();
+	void renderPostFx(glm::ivec2 vp_size, glm::ivec2 vp_offset);
+
 	void imguiInit();
 	void imguiDestroy();
 
@@ -0,0 +1,86 @@
+/*
+	D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+	Copyright (C) 2023  Bayaraa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "dirty_tiles.h"
+
+namespace d2gl {
+
+void DirtyTiles::update(const uint8_t* data, glm::uvec2 size, uint32_t bit)
+{
+	const size_t pitch = (size_t)size.x * bit;
+	m_regions.clear();
+
+	if (size != m_size || bit != m_bit || m_previous.empty()) {
+		m_size = size;
+		m_bit = bit;
+		m_previous.assign(data, data + pitch * size.y);
+		m_regions.push_back({ { 0, 0 }, size });
+		return;
+	}
+
+	const uint32_t cols = (size.x + DIRTY_TILE_WIDTH - 1) / DIRTY_TILE_WIDTH;
+	uint64_t dirty_pixels = 0;
+
+	for (uint32_t y0 = 0; y0 < size.y; y0 += DIRTY_TILE_HEIGHT) {
+		const uint32_t height = std::min<uint32_t>(DIRTY_TILE_HEIGHT, size.y - y0);
+		uint32_t span_start = UINT32_MAX;
+
+		for (uint32_t col = 0; col <= cols; col++) {
+			bool dirty = false;
+			if (col < cols) {
+				const size_t offset = (size_t)col * DIRTY_TILE_WIDTH * bit;
+				const size_t length = (size_t)std::min<uint32_t>(DIRTY_TILE_WIDTH, size.x - col * DIRTY_TILE_WIDTH) * bit;
+				for (uint32_t y = y0; y < y0 + height && !dirty; y++)
+					dirty = memcmp(data + y * pitch + offset, m_previous.data() + y * pitch + offset, length) != 0;
+			}
+
+			if (dirty && span_start == UINT32_MAX)
+				span_start = col;
+			else if (!dirty && span_start != UINT32_MAX) {
+				const uint32_t x0 = span_start * DIRTY_TILE_WIDTH;
+				const uint32_t width = std::min(col * DIRTY_TILE_WIDTH, size.x) - x0;
+				m_regions.push_back({ { x0, y0 }, { width, height } });
+				dirty_pixels += (uint64_t)width * height;
+				span_start = UINT32_MAX;
+			}
+		}
+	}
+
+	// Past this a single full upload is cheaper than many small ones.
+	if (m_regions.size() > MAX_DIRTY_REGIONS || dirty_pixels * 4 > (uint64_t)size.x * size.y * 3) {
+		m_previous.assign(data, data + pitch * size.y);
+		m_regions.clear();
+		m_regions.push_back({ { 0, 0 }, size });
+		return;
+	}
+
+	for (auto& region : m_regions) {
+		const size_t offset = (size_t)region.pos.x * bit;
+		const size_t length = (size_t)region.size.x * bit;
+		for (uint32_t y = region.pos.y; y < (uint32_t)region.pos.y + region.size.y; y++)
+			memcpy(m_previous.data() + y * pitch + offset, data + y * pitch + offset, length);
+	}
+}
+
+void DirtyTiles::invalidate()
+{
+	m_previous.clear();
+}
+
+}
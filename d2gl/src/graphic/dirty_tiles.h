@@ -0,0 +1,45 @@
+/*
+	D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+	Copyright (C) 2023  Bayaraa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#define DIRTY_TILE_WIDTH 64
+#define DIRTY_TILE_HEIGHT 16
+#define MAX_DIRTY_REGIONS 1024
+
+namespace d2gl {
+
+struct DirtyRegion {
+	glm::vec<2, uint16_t> pos = { 0, 0 };
+	glm::vec<2, uint16_t> size = { 0, 0 };
+};
+
+class DirtyTiles {
+	std::vector<uint8_t> m_previous;
+	glm::uvec2 m_size = { 0, 0 };
+	uint32_t m_bit = 0;
+	std::vector<DirtyRegion> m_regions;
+
+public:
+	// Diffs a frame against the previous one, changed tiles are merged into horizontal spans.
+	void update(const uint8_t* data, glm::uvec2 size, uint32_t bit);
+	void invalidate();
+
+	inline const std::vector<DirtyRegion>& getRegions() const { return m_regions; }
+};
+
+}
@@ -18,17 +18,16 @@
 
 #include "pch.h"
 #include "frame_buffer.h"
+#include "gl_state.h"
 #include "texture.h"
 
 namespace d2gl {
 
-GLuint current_binded_fbo = 0;
-
 FrameBuffer::FrameBuffer(const FrameBufferCreateInfo& info)
-	: m_width(info.size.x), m_height(info.size.y), m_attachment_count(info.attachments.size())
+	: m_width(info.size.x), m_height(info.size.y), m_attachment_count(info.attachments.size()), m_info(info)
 {
 	glGenFramebuffers(1, &m_id);
-	glBindFramebuffer(GL_FRAMEBUFFER, m_id);
+	GLState::Instance().bindFrameBuffer(m_id);
 
 	TextureCreateInfo texture_ci;
 	texture_ci.size = info.size;
@@ -52,27 +51,20 @@ FrameBuffer::FrameBuffer(const FrameBufferCreateInfo& info)
 		m_complete = false;
 	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	current_binded_fbo = 0;
+	GLState::Instance().bindFrameBuffer(0);
 }
 
 FrameBuffer::~FrameBuffer()
 {
 	for (auto& texture : m_textures)
 		texture.reset();
+	GLState::Instance().onDeleteFrameBuffer(m_id);
 	glDeleteFramebuffers(1, &m_id);
 }
 
 void FrameBuffer::bind(bool clear)
 {
-	if (current_binded_fbo == m_id) {
-		if (clear)
-			clearBuffer();
-		return;
-	}
-
-	glBindFramebuffer(GL_FRAMEBUFFER, m_id);
-	current_binded_fbo = m_id;
+	GLState::Instance().bindFrameBuffer(m_id);
 
 	if (clear)
 		clearBuffer();
@@ -80,11 +72,7 @@ void FrameBuffer::bind(bool clear)
 
 void FrameBuffer::unBind()
 {
-	if (current_binded_fbo == 0)
-		return;
-
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
-	current_binded_fbo = 0;
+	GLState::Instance().bindFrameBuffer(0);
 }
 
 void FrameBuffer::clearBuffer()
@@ -100,6 +88,28 @@ void FrameBuffer::clearBuffer()
 	}
 }
 
+// Texture must match the attachment size and format, the slots stay where they were.
+void FrameBuffer::swapTexture(uint32_t index, std::unique_ptr<Texture>& texture)
+{
+	const uint32_t slot = m_textures[index]->getSlot();
+	m_textures[index]->setSlot(texture->getSlot());
+	texture->setSlot(slot);
+	m_textures[index].swap(texture);
+
+	GLState::Instance().bindFrameBuffer(m_id);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + index, GL_TEXTURE_2D, m_textures[index]->getId(), 0);
+}
+
+// Info must only differ in slots and clear colors.
+void FrameBuffer::reuse(const FrameBufferCreateInfo& info)
+{
+	for (size_t i = 0; i < m_attachment_count; i++) {
+		m_textures[i]->setSlot(info.attachments[i].slot);
+		m_clear_colors[i] = info.attachments[i].clear_color;
+	}
+	m_info = info;
+}
+
 void FrameBuffer::setDrawBuffers(uint32_t count)
 {
 	GLenum* attachments = new GLenum[count];
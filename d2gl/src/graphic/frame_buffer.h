@@ -40,6 +40,7 @@ class FrameBuffer {
 	std::vector<std::unique_ptr<Texture>> m_textures;
 	std::vector<std::array<float, 4>> m_clear_colors;
 	bool m_complete = true;
+	FrameBufferCreateInfo m_info;
 
 public:
 	FrameBuffer(const FrameBufferCreateInfo& info);
@@ -48,6 +49,8 @@ public:
 	void bind(bool clear = true);
 	static void unBind();
 	static void setDrawBuffers(uint32_t count);
+	void swapTexture(uint32_t index, std::unique_ptr<Texture>& texture);
+	void reuse(const FrameBufferCreateInfo& info);
 
 	inline const GLuint getId() const { return m_id; }
 	inline Texture* getTexture(uint32_t index = 0) { return m_textures[index].get(); }
@@ -55,6 +58,7 @@ public:
 	inline const uint32_t getHeight() const { return m_height; }
 	inline const uint32_t getAttachmentCount() const { return m_attachment_count; }
 	inline bool isComplete() { return m_complete; }
+	inline const FrameBufferCreateInfo& getInfo() const { return m_info; }
 
 private:
 	void clearBuffer();
@@ -0,0 +1,162 @@
+/*
+D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+Copyright (C) 2023  Bayaraa
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+// Kept free of game and GL dependencies so tools/governor_eval can replay timing traces offline.
+
+namespace d2gl {
+
+struct FrameGovernorParams {
+	double budget_ms = 1000.0 / 60.0;
+	double down_ratio = 1.0;      // step down when the window average exceeds budget * down_ratio
+	double up_ratio = 0.7;        // step up when it drops below budget * up_ratio
+	uint32_t window = 60;         // frames averaged per decision
+	uint32_t confirm = 2;         // consecutive windows over budget before stepping down
+	uint32_t cooldown = 120;      // frames ignored after a level change
+	uint32_t max_backoff = 8;     // cap of the step up cooldown multiplier
+};
+
+class FrameGovernor {
+	uint32_t m_level = 0;
+	uint32_t m_max_level = 0;
+	uint32_t m_cooldown = 0;
+	uint32_t m_backoff = 1;
+	uint32_t m_stable_frames = 0;
+	bool m_stepped_up = false;
+	uint32_t m_over_count = 0;
+	uint32_t m_sample_count = 0;
+	double m_sample_sum = 0.0;
+
+public:
+	// Level 0 is full quality, every level above drops one more quality step.
+	inline void reset(uint32_t max_level)
+	{
+		m_level = 0;
+		m_max_level = max_level;
+		m_cooldown = 0;
+		m_backoff = 1;
+		m_stable_frames = 0;
+		m_stepped_up = false;
+		m_over_count = 0;
+		m_sample_count = 0;
+		m_sample_sum = 0.0;
+	}
+
+	// Returns true when the level changed.
+	inline bool update(double frame_ms, const FrameGovernorParams& params)
+	{
+		m_stable_frames++;
+		if (m_cooldown) {
+			m_cooldown--;
+			return false;
+		}
+
+		m_sample_sum += frame_ms;
+		if (++m_sample_count < params.window)
+			return false;
+
+		const double average = m_sample_sum / m_sample_count;
+		m_sample_sum = 0.0;
+		m_sample_count = 0;
+
+		m_over_count = average > params.budget_ms * params.down_ratio ? m_over_count + 1 : 0;
+		if (m_over_count >= params.confirm && m_level < m_max_level) {
+			// The last step up did not hold, wait longer before trying it again.
+			if (m_stepped_up && m_stable_frames <= params.cooldown * m_backoff + params.window * 2)
+				m_backoff = m_backoff * 2 > params.max_backoff ? params.max_backoff : m_backoff * 2;
+
+			m_level++;
+			m_over_count = 0;
+			m_cooldown = params.cooldown;
+			m_stable_frames = 0;
+			m_stepped_up = false;
+			return true;
+		}
+
+		if (average < params.budget_ms * params.up_ratio && m_level > 0) {
+			m_level--;
+			m_cooldown = params.cooldown * m_backoff;
+			m_stable_frames = 0;
+			m_stepped_up = true;
+			return true;
+		}
+
+		if (m_stable_frames > params.cooldown * params.max_backoff * 4)
+			m_backoff = 1;
+
+		return false;
+	}
+
+	// Drops the steps above max_level without restarting the measurement.
+	inline void setMaxLevel(uint32_t max_level)
+	{
+		m_max_level = max_level;
+		if (m_level > max_level)
+			m_level = max_level;
+	}
+
+	inline uint32_t getLevel() const { return m_level; }
+	inline uint32_t getMaxLevel() const { return m_max_level; }
+};
+
+struct DynamicResolutionParams {
+	double budget_ms = 1000.0 / 60.0;
+	double min_scale = 0.5;
+	double step = 0.05;           // scale changes are quantized to this
+	double smoothing = 0.1;       // weight of the newest frame in the moving averages
+	double headroom = 0.9;        // fraction of the budget aimed for
+};
+
+class DynamicResolution {
+	double m_scale = 1.0;
+	double m_target = 1.0;
+	double m_average = 0.0;
+
+public:
+	inline void reset()
+	{
+		m_scale = 1.0;
+		m_target = 1.0;
+		m_average = 0.0;
+	}
+
+	// Returns true when the quantized scale changed.
+	inline bool update(double frame_ms, const DynamicResolutionParams& params)
+	{
+		m_average = m_average > 0.0 ? m_average + (frame_ms - m_average) * params.smoothing : frame_ms;
+		if (m_average <= 0.0)
+			return false;
+
+		// Pixel count, and so the cost of the scaled passes, grows with the square of the scale.
+		const double wanted = m_scale * std::sqrt(params.budget_ms * params.headroom / m_average);
+		m_target = std::fmin(std::fmax(m_target + (wanted - m_target) * params.smoothing, params.min_scale), 1.0);
+		if (std::fabs(m_target - m_scale) < params.step)
+			return false;
+
+		m_scale = std::fmin(std::fmax(std::round(m_target / params.step) * params.step, params.min_scale), 1.0);
+		return true;
+	}
+
+	inline double getScale() const { return m_scale; }
+};
+
+}
@@ -0,0 +1,220 @@
+/*
+	D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+	Copyright (C) 2023  Bayaraa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "gl_state.h"
+
+namespace d2gl {
+
+#define GL_STATE_UNKNOWN UINT32_MAX
+
+GLState::GLState()
+{
+	invalidate();
+}
+
+void GLState::useProgram(GLuint id)
+{
+	if (filter(GLStateCall::Program, m_program == id))
+		return;
+
+	glUseProgram(id);
+	m_program = id;
+}
+
+void GLState::setBlend(bool enable)
+{
+	if (filter(GLStateCall::Blend, m_blend == (int8_t)enable))
+		return;
+
+	enable ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
+	m_blend = (int8_t)enable;
+}
+
+void GLState::setBlendFunc(const BlendFactors& factors)
+{
+	bool redundant = true;
+	for (auto& funcs : m_blend_funcs)
+		redundant &= !memcmp(&funcs, &factors, sizeof(BlendFactors));
+
+	if (filter(GLStateCall::BlendFunc, redundant))
+		return;
+
+	glBlendFuncSeparate(factors.src_color, factors.dst_color, factors.src_alpha, factors.dst_alpha);
+	for (auto& funcs : m_blend_funcs)
+		funcs = factors;
+}
+
+void GLState::setBlendFunc(uint32_t draw_buffer, const BlendFactors& factors)
+{
+	if (draw_buffer < GL_STATE_DRAW_BUFFERS && filter(GLStateCall::BlendFunc, !memcmp(&m_blend_funcs[draw_buffer], &factors, sizeof(BlendFactors))))
+		return;
+
+	glBlendFuncSeparatei(draw_buffer, factors.src_color, factors.dst_color, factors.src_alpha, factors.dst_alpha);
+	if (draw_buffer < GL_STATE_DRAW_BUFFERS)
+		m_blend_funcs[draw_buffer] = factors;
+}
+
+void GLState::bindTexture(uint32_t unit, GLenum target, GLuint id, bool force)
+{
+	// Forcing only makes the unit active, for texture uploads and parameter changes.
+	const bool bound = m_textures[unit] == id;
+	if (!force && filter(GLStateCall::Texture, bound))
+		return;
+
+	if (!filter(GLStateCall::ActiveTexture, m_active_unit == unit)) {
+		glActiveTexture(GL_TEXTURE0 + unit);
+		m_active_unit = unit;
+	}
+
+	if (force && filter(GLStateCall::Texture, bound))
+		return;
+
+	glBindTexture(target, id);
+	m_textures[unit] = id;
+}
+
+void GLState::bindFrameBuffer(GLuint id)
+{
+	if (filter(GLStateCall::FrameBuffer, m_frame_buffer == id))
+		return;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, id);
+	m_frame_buffer = id;
+}
+
+void GLState::setViewport(glm::ivec2 size, glm::ivec2 offset)
+{
+	const auto metrics = glm::ivec4(size, offset);
+	if (filter(GLStateCall::Viewport, m_viewport == metrics))
+		return;
+
+	glViewport(offset.x, offset.y, size.x, size.y);
+	m_viewport = metrics;
+}
+
+void GLState::bindVertexArray(GLuint id)
+{
+	if (filter(GLStateCall::VertexArray, m_vertex_array == id))
+		return;
+
+	glBindVertexArray(id);
+	m_vertex_array = id;
+}
+
+void GLState::bindBuffer(GLenum target, GLuint id)
+{
+	const int index = getBufferIndex(target);
+	if (index > -1 && filter(GLStateCall::Buffer, m_buffers[index] == id))
+		return;
+
+	glBindBuffer(target, id);
+	if (index > -1)
+		m_buffers[index] = id;
+}
+
+void GLState::bindBufferRange(GLenum target, uint32_t index, GLuint id, GLintptr offset, GLsizeiptr size)
+{
+	filter(GLStateCall::Buffer, false);
+	glBindBufferRange(target, index, id, offset, size);
+
+	// Also replaces the generic binding of the target.
+	if (const int buffer_index = getBufferIndex(target); buffer_index > -1)
+		m_buffers[buffer_index] = id;
+}
+
+void GLState::onDeleteProgram(GLuint id)
+{
+	// A deleted program stays in use until replaced, its name may be reused meanwhile.
+	if (m_program == id)
+		m_program = GL_STATE_UNKNOWN;
+}
+
+void GLState::onDeleteTexture(GLuint id)
+{
+	for (auto& texture : m_textures) {
+		if (texture == id)
+			texture = 0;
+	}
+}
+
+void GLState::onDeleteFrameBuffer(GLuint id)
+{
+	if (m_frame_buffer == id)
+		m_frame_buffer = 0;
+}
+
+void GLState::onDeleteBuffer(GLuint id)
+{
+	for (auto& buffer : m_buffers) {
+		if (buffer == id)
+			buffer = 0;
+	}
+}
+
+void GLState::invalidate()
+{
+	m_program = GL_STATE_UNKNOWN;
+	m_blend = -1;
+	memset(m_blend_funcs, 0xFF, sizeof(m_blend_funcs));
+	m_active_unit = GL_STATE_UNKNOWN;
+	for (auto& texture : m_textures)
+		texture = GL_STATE_UNKNOWN;
+	m_frame_buffer = GL_STATE_UNKNOWN;
+	m_viewport = { -1, -1, -1, -1 };
+	m_vertex_array = GL_STATE_UNKNOWN;
+	for (auto& buffer : m_buffers)
+		buffer = GL_STATE_UNKNOWN;
+}
+
+void GLState::endFrame()
+{
+	for (size_t i = 0; i < (size_t)GLStateCall::Count; i++) {
+		m_frame_counters[i] = m_counters[i];
+		m_counters[i] = {};
+	}
+}
+
+const char* GLState::getCallName(GLStateCall call)
+{
+	switch (call) {
+		case GLStateCall::Program: return "Program";
+		case GLStateCall::Blend: return "Blend";
+		case GLStateCall::BlendFunc: return "BlendFunc";
+		case GLStateCall::ActiveTexture: return "ActiveTexture";
+		case GLStateCall::Texture: return "Texture";
+		case GLStateCall::FrameBuffer: return "FrameBuffer";
+		case GLStateCall::Viewport: return "Viewport";
+		case GLStateCall::VertexArray: return "VertexArray";
+		case GLStateCall::Buffer: return "Buffer";
+	}
+	return "";
+}
+
+int GLState::getBufferIndex(GLenum target)
+{
+	switch (target) {
+		case GL_ARRAY_BUFFER: return 0;
+		case GL_PIXEL_UNPACK_BUFFER: return 1;
+		case GL_UNIFORM_BUFFER: return 2;
+		case GL_PIXEL_PACK_BUFFER: return 3;
+	}
+	return -1;
+}
+
+}
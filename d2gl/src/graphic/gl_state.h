@@ -0,0 +1,109 @@
+/*
+	D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+	Copyright (C) 2023  Bayaraa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#define GL_STATE_TEXTURE_UNITS 32
+#define GL_STATE_DRAW_BUFFERS 8
+#define GL_STATE_BUFFER_TARGETS 4
+
+namespace d2gl {
+
+struct BlendFactors {
+	GLenum src_color;
+	GLenum dst_color;
+	GLenum src_alpha;
+	GLenum dst_alpha;
+};
+
+enum class GLStateCall {
+	Program,
+	Blend,
+	BlendFunc,
+	ActiveTexture,
+	Texture,
+	FrameBuffer,
+	Viewport,
+	VertexArray,
+	Buffer,
+	Count,
+};
+
+struct GLStateCounter {
+	uint32_t issued = 0;
+	uint32_t filtered = 0;
+};
+
+class GLState {
+	GLuint m_program = 0;
+	int8_t m_blend = -1;
+	BlendFactors m_blend_funcs[GL_STATE_DRAW_BUFFERS] = {};
+	uint32_t m_active_unit = 0;
+	GLuint m_textures[GL_STATE_TEXTURE_UNITS] = {};
+	GLuint m_frame_buffer = 0;
+	glm::ivec4 m_viewport = { 0, 0, 0, 0 };
+	GLuint m_vertex_array = 0;
+	GLuint m_buffers[GL_STATE_BUFFER_TARGETS] = {};
+
+	GLStateCounter m_counters[(size_t)GLStateCall::Count];
+	GLStateCounter m_frame_counters[(size_t)GLStateCall::Count];
+
+	GLState();
+	~GLState() = default;
+
+public:
+	static GLState& Instance()
+	{
+		static GLState instance;
+		return instance;
+	}
+
+	void useProgram(GLuint id);
+	void setBlend(bool enable);
+	void setBlendFunc(const BlendFactors& factors);
+	void setBlendFunc(uint32_t draw_buffer, const BlendFactors& factors);
+	void bindTexture(uint32_t unit, GLenum target, GLuint id, bool force = false);
+	void bindFrameBuffer(GLuint id);
+	void setViewport(glm::ivec2 size, glm::ivec2 offset);
+	void bindVertexArray(GLuint id);
+	void bindBuffer(GLenum target, GLuint id);
+	void bindBufferRange(GLenum target, uint32_t index, GLuint id, GLintptr offset, GLsizeiptr size);
+
+	void onDeleteProgram(GLuint id);
+	void onDeleteTexture(GLuint id);
+	void onDeleteFrameBuffer(GLuint id);
+	void onDeleteBuffer(GLuint id);
+
+	// Forget everything, state changed outside of the tracker (ImGui rendering, driver resets).
+	void invalidate();
+	void endFrame();
+
+	inline const GLStateCounter& getCounter(GLStateCall call) const { return m_frame_counters[(size_t)call]; }
+	static const char* getCallName(GLStateCall call);
+
+private:
+	inline bool filter(GLStateCall call, bool redundant)
+	{
+		auto& counter = m_counters[(size_t)call];
+		redundant ? counter.filtered++ : counter.issued++;
+		return redundant;
+	}
+	static int getBufferIndex(GLenum target);
+};
+
+}
@@ -22,81 +22,59 @@
 namespace d2gl {
 
 Object::Object(glm::vec2 position, glm::vec2 size)
-	: m_position(position), m_size(size)
 {
-	for (size_t i = 0; i < 4; i++) {
-		m_vertices[i].color1 = 0xFFFFFFFF;
-		m_vertices[i].color2 = 0xFFFFFFFF;
-		m_vertices[i].tex_ids = { 0, 0 };
-	}
-	setPosition(position);
+	m_instance.position = position;
+	m_instance.size = size;
+	m_instance.color1 = 0xFFFFFFFF;
+	m_instance.color2 = 0xFFFFFFFF;
+	m_instance.tex_ids = { 0, 0 };
+	m_instance.extra = { 0, 0, 0, 0 };
 	setTexCoord({ 0.0f, 0.0f, 1.0f, 1.0f });
 	setFlags();
 }
 
 void Object::setPosition(glm::vec2 position)
 {
-	m_position = position;
-	m_vertices[0].position = { glm::detail::toFloat16(m_position.x), glm::detail::toFloat16(m_position.y) };
-	m_vertices[1].position = { glm::detail::toFloat16(m_position.x + m_size.x), glm::detail::toFloat16(m_position.y) };
-	m_vertices[2].position = { glm::detail::toFloat16(m_position.x + m_size.x), glm::detail::toFloat16(m_position.y + m_size.y) };
-	m_vertices[3].position = { glm::detail::toFloat16(m_position.x), glm::detail::toFloat16(m_position.y + m_size.y) };
+	m_instance.position = position;
 }
 
 void Object::setSize(glm::vec2 size)
 {
-	m_size = size;
-	m_vertices[1].position.x = glm::detail::toFloat16(m_position.x + m_size.x);
-	m_vertices[2].position = { glm::detail::toFloat16(m_position.x + m_size.x), glm::detail::toFloat16(m_position.y + m_size.y) };
-	m_vertices[3].position.y = glm::detail::toFloat16(m_position.y + m_size.y);
+	m_instance.size = size;
 }
 
 void Object::setTexCoord(glm::vec4 tex_coord)
 {
-	m_vertices[0].tex_coord = { tex_coord.x, tex_coord.w };
-	m_vertices[1].tex_coord = { tex_coord.z, tex_coord.w };
-	m_vertices[2].tex_coord = { tex_coord.z, tex_coord.y };
-	m_vertices[3].tex_coord = { tex_coord.x, tex_coord.y };
+	m_instance.tex_coord = tex_coord;
 }
 
 void Object::setTexIds(glm::vec<2, int16_t> tex_ids)
 {
-	m_vertices[0].tex_ids = tex_ids;
-	m_vertices[1].tex_ids = tex_ids;
-	m_vertices[2].tex_ids = tex_ids;
-	m_vertices[3].tex_ids = tex_ids;
+	m_instance.tex_ids = tex_ids;
 }
 
 void Object::setColor(uint32_t color, int num)
 {
-	if (num == 1) {
-		m_vertices[0].color1 = color;
-		m_vertices[1].color1 = color;
-		m_vertices[2].color1 = color;
-		m_vertices[3].color1 = color;
-	} else {
-		m_vertices[0].color2 = color;
-		m_vertices[1].color2 = color;
-		m_vertices[2].color2 = color;
-		m_vertices[3].color2 = color;
-	}
+	if (num == 1)
+		m_instance.color1 = color;
+	else
+		m_instance.color2 = color;
 }
 
 void Object::setFlags(uint8_t x, uint8_t y, uint8_t z, uint8_t w)
 {
-	const glm::vec<4, uint8_t> flags = { x, y, z, w };
-	m_vertices[0].flags = flags;
-	m_vertices[1].flags = flags;
-	m_vertices[2].flags = flags;
-	m_vertices[3].flags = flags;
+	m_instance.flags = { x, y, z, w };
 }
 
 void Object::setExtra(glm::vec2 extra)
 {
-	m_vertices[0].extra = { glm::detail::toFloat16(extra.x), glm::detail::toFloat16(extra.y) };
-	m_vertices[1].extra = m_vertices[0].extra;
-	m_vertices[2].extra = m_vertices[0].extra;
-	m_vertices[3].extra = m_vertices[0].extra;
+	m_instance.extra.x = glm::detail::toFloat16(extra.x);
+	m_instance.extra.y = glm::detail::toFloat16(extra.y);
+}
+
+void Object::setExtra(glm::vec4 extra)
+{
+	m_instance.extra = { glm::detail::toFloat16(extra.x), glm::detail::toFloat16(extra.y), glm::detail::toFloat16(extra.z), glm::detail::toFloat16(extra.w) };
 }
 
 }
\ No newline at end of file
@@ -24,9 +24,7 @@
 namespace d2gl {
 
 class Object {
-	VertexMod m_vertices[4];
-	glm::vec2 m_position;
-	glm::vec2 m_size;
+	InstanceMod m_instance;
 
 public:
 	Object(glm::vec2 position = { 0.0f, 0.0f }, glm::vec2 size = { 0.0f, 0.0f });
@@ -39,8 +37,9 @@ public:
 	void setColor(uint32_t color, int num = 1);
 	void setFlags(uint8_t x = 0, uint8_t y = 0, uint8_t z = 0, uint8_t w = 0);
 	void setExtra(glm::vec2 extra);
+	void setExtra(glm::vec4 extra);
 
-	inline const VertexMod* getVertices() { return m_vertices; };
+	inline const InstanceMod* getInstance() { return &m_instance; };
 };
 
 }
\ No newline at end of file
@@ -19,6 +19,7 @@
 #include "pch.h"
 #include "pipeline.h"
 #include "frame_buffer.h"
+#include "program_cache.h"
 #include "texture.h"
 #include "uniform_buffer.h"
 
@@ -29,6 +30,40 @@ Pipeline::Pipeline(const PipelineCreateInfo& info)
 {
 	m_id = glCreateProgram();
 
+	const bool cacheable = App.gl_caps.program_binary && info.shader;
+	const auto cache_key = cacheable ? ProgramCache::getKey(info.shader, info.version, m_compute) : ProgramCacheKey();
+	if (!cacheable || !ProgramCache::load(cache_key, m_id)) {
+		linkProgram(info);
+		if (cacheable && m_compile_success)
+			ProgramCache::save(cache_key, m_id);
+	}
+
+	GLState::Instance().useProgram(m_id);
+
+	if (m_compile_success && m_bindings.size() > 0) {
+		for (auto& binding : m_bindings) {
+			switch (binding.type) {
+				case BindingType::UniformBuffer: {
+					GLuint ubo_index = glGetUniformBlockIndex(m_id, binding.name.c_str());
+					glUniformBlockBinding(m_id, ubo_index, binding.value);
+					break;
+				}
+				case BindingType::Texture:
+				case BindingType::Image:
+				case BindingType::FBTexture: {
+					setUniform1i(binding.name, binding.value);
+					break;
+				}
+			};
+		}
+	}
+
+	if (m_compile_success && m_compute)
+		m_flag_uniform = getUniformHandle("u_Flag");
+}
+
+void Pipeline::linkProgram(const PipelineCreateInfo& info)
+{
 	GLuint vs = 0, fs = 0, cs = 0;
 	if (m_compute) {
 		cs = createShader(info.shader, GL_COMPUTE_SHADER, info.version, m_name);
@@ -47,56 +82,31 @@ Pipeline::Pipeline(const PipelineCreateInfo& info)
 			m_compile_success = false;
 	}
 
+	if (App.gl_caps.program_binary)
+		glProgramParameteri(m_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
 	glLinkProgram(m_id);
 	glValidateProgram(m_id);
 	glDeleteShader(vs);
 	glDeleteShader(fs);
 	glDeleteShader(cs);
 
-	glUseProgram(m_id);
-
-	if (m_compile_success && m_bindings.size() > 0) {
-		for (auto& binding : m_bindings) {
-			switch (binding.type) {
-				case BindingType::UniformBuffer: {
-					GLuint ubo_index = glGetUniformBlockIndex(m_id, binding.name.c_str());
-					glUniformBlockBinding(m_id, ubo_index, binding.value);
-					break;
-				}
-				case BindingType::Texture:
-				case BindingType::Image:
-				case BindingType::FBTexture: {
-					setUniform1i(binding.name, binding.value);
-					break;
-				}
-			};
-		}
-	}
+	GLint status = GL_FALSE;
+	glGetProgramiv(m_id, GL_LINK_STATUS, &status);
+	if (status == GL_FALSE)
+		m_compile_success = false;
 }
 
 Pipeline::~Pipeline()
 {
+	GLState::Instance().onDeleteProgram(m_id);
 	glDeleteProgram(m_id);
 }
 
 void Pipeline::bind(uint32_t index)
 {
-	static GLuint current_program = 0;
-	static uint32_t current_blend_index = 10;
-
-	if (current_program == m_id && current_blend_index == index)
-		return;
-
-	if (current_program != m_id) {
-		glUseProgram(m_id);
-		current_program = m_id;
-		current_blend_index = 10;
-	}
-
-	if (current_blend_index != index) {
-		setBlendState(index);
-		current_blend_index = index;
-	}
+	GLState::Instance().useProgram(m_id);
+	setBlendState(index);
 
 	if (m_bindings.size() > 0) {
 		for (auto& binding : m_bindings) {
@@ -115,30 +125,20 @@ void Pipeline::bind(uint32_t index)
 
 void Pipeline::setBlendState(uint32_t index)
 {
-	static bool blend_enabled = true;
+	auto& state = GLState::Instance();
 
 	const auto& blends = m_attachment_blends[index];
 	if (blends[0] == BlendType::NoBlend) {
-		if (blend_enabled) {
-			glDisable(GL_BLEND);
-			blend_enabled = false;
-		}
+		state.setBlend(false);
 		return;
 	}
 
-	if (!blend_enabled) {
-		glEnable(GL_BLEND);
-		blend_enabled = true;
-	}
+	state.setBlend(true);
 	if (App.gl_caps.independent_blending) {
-		for (size_t i = 0; i < blends.size(); i++) {
-			const auto factor = blendFactor(blends[i]);
-			glBlendFuncSeparatei(i, factor.src_color, factor.dst_color, factor.src_alpha, factor.dst_alpha);
-		}
-	} else {
-		const auto factor = blendFactor(blends[0]);
-		glBlendFuncSeparate(factor.src_color, factor.dst_color, factor.src_alpha, factor.dst_alpha);
-	}
+		for (size_t i = 0; i < blends.size(); i++)
+			state.setBlendFunc(i, blendFactor(blends[i]));
+	} else
+		state.setBlendFunc(blendFactor(blends[0]));
 }
 
 BlendFactors Pipeline::blendFactor(BlendType type)
@@ -198,9 +198,45 @@ void Pipeline::setUniformMat4f(const std::string& name, const glm::mat4& matrix)
 	glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &matrix[0][0]);
 }
 
+UniformHandle Pipeline::getUniformHandle(const std::string& name)
+{
+	return { getUniformLocation(name) };
+}
+
+void Pipeline::setUniform1i(UniformHandle handle, int value)
+{
+	glUniform1i(handle.location, value);
+}
+
+void Pipeline::setUniform1u(UniformHandle handle, uint32_t value)
+{
+	glUniform1ui(handle.location, value);
+}
+
+void Pipeline::setUniform1f(UniformHandle handle, float value)
+{
+	glUniform1f(handle.location, value);
+}
+
+void Pipeline::setUniformVec2f(UniformHandle handle, const glm::vec2& value)
+{
+	glUniform2fv(handle.location, 1, &value.x);
+}
+
+void Pipeline::setUniformVec4f(UniformHandle handle, const glm::vec4& value)
+{
+	glUniform4fv(handle.location, 1, &value.x);
+}
+
+void Pipeline::setUniformMat4f(UniformHandle handle, const glm::mat4& matrix)
+{
+	glUniformMatrix4fv(handle.location, 1, GL_FALSE, &matrix[0][0]);
+}
+
 void Pipeline::dispatchCompute(int flag, glm::ivec2 work_size, GLbitfield barrier)
 {
-	setUniform1u("u_Flag", flag);
+	bind();
+	setUniform1u(m_flag_uniform, flag);
 	glDispatchCompute(work_size.x, work_size.y, 1);
 
 	if (barrier)
@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include "gl_state.h"
+
 namespace d2gl {
 
 class UniformBuffer;
@@ -58,11 +60,8 @@ struct BindingInfo {
 	uint32_t index = 0;
 };
 
-struct BlendFactors {
-	GLenum src_color;
-	GLenum dst_color;
-	GLenum src_alpha;
-	GLenum dst_alpha;
+struct UniformHandle {
+	GLint location = -1;
 };
 
 typedef std::vector<std::vector<BlendType>> AttachmentBlends;
@@ -89,6 +88,7 @@ class Pipeline {
 	AttachmentBlends m_attachment_blends;
 	std::unordered_map<std::string, GLint> m_uniform_cache;
 	std::vector<BindingInfo> m_bindings;
+	UniformHandle m_flag_uniform;
 	bool m_compute = false;
 	bool m_compile_success = true;
 
@@ -107,12 +107,22 @@ public:
 	void setUniformVec4f(const std::string& name, const glm::vec4& value);
 	void setUniformMat4f(const std::string& name, const glm::mat4& matrix);
 
+	// Handle setters do not bind, the pipeline must already be bound.
+	UniformHandle getUniformHandle(const std::string& name);
+	void setUniform1i(UniformHandle handle, int value);
+	void setUniform1u(UniformHandle handle, uint32_t value);
+	void setUniform1f(UniformHandle handle, float value);
+	void setUniformVec2f(UniformHandle handle, const glm::vec2& value);
+	void setUniformVec4f(UniformHandle handle, const glm::vec4& value);
+	void setUniformMat4f(UniformHandle handle, const glm::mat4& matrix);
+
 	inline const GLuint getId() const { return m_id; }
 	inline void updateBindings(std::vector<BindingInfo> bindings) { m_bindings = bindings; }
 	inline bool uniformExist(const std::string& name) { return glGetUniformLocation(m_id, name.c_str()) > -1; }
 	inline bool isCompileSuccess() { return m_compile_success; }
 
 private:
+	void linkProgram(const PipelineCreateInfo& info);
 	void setBlendState(uint32_t index = 0);
 
 	static BlendFactors blendFactor(BlendType type);
@@ -0,0 +1,154 @@
+/*
+	D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+	Copyright (C) 2023  Bayaraa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "program_cache.h"
+#include "helpers.h"
+
+namespace d2gl {
+
+#define PROGRAM_CACHE_MAGIC 0x42503244 // "D2PB"
+
+ProgramCacheKey ProgramCache::getKey(const char* source, glm::vec<2, uint8_t> version, bool compute)
+{
+	ProgramCacheKey key;
+	key.defines = getDriverString() + "|" + std::to_string(version.x) + std::to_string(version.y) + (compute ? "|compute" : "|graphics");
+	key.source = source;
+
+	const uint32_t source_hash = helpers::hash(source, strlen(source));
+	const uint32_t defines_hash = helpers::hash(key.defines.data(), key.defines.size());
+	key.hash = ((uint64_t)source_hash << 32) | defines_hash;
+
+	return key;
+}
+
+bool ProgramCache::load(const ProgramCacheKey& key, GLuint program)
+{
+	std::ifstream file(getFilePath(key.hash), std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return false;
+
+	const uint64_t file_size = (uint64_t)file.tellg();
+	file.seekg(0);
+
+	auto readU32 = [&file]() {
+		uint32_t value = 0;
+		file.read((char*)&value, sizeof(value));
+		return value;
+	};
+	// Lengths come from the file, a corrupt one must not turn into a huge allocation.
+	auto readBlock = [&file, &readU32, file_size](std::string& block) {
+		const uint32_t size = readU32();
+		if (!file || size > file_size - (uint64_t)file.tellg())
+			return false;
+		block.resize(size);
+		file.read(block.data(), size);
+		return (bool)file;
+	};
+
+	if (readU32() != PROGRAM_CACHE_MAGIC || readU32() != PROGRAM_CACHE_VERSION)
+		return false;
+
+	std::string defines, source;
+	if (!readBlock(defines) || defines != key.defines || !readBlock(source) || source != key.source)
+		return false;
+
+	const GLenum format = readU32();
+	std::string binary;
+	if (!readBlock(binary) || binary.empty())
+		return false;
+
+	// Drivers may reject a binary at any time, the caller compiles from source then.
+	glProgramBinary(program, format, binary.data(), (GLsizei)binary.size());
+
+	GLint status = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	return status == GL_TRUE;
+}
+
+void ProgramCache::save(const ProgramCacheKey& key, GLuint program)
+{
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return;
+
+	GLenum format = 0;
+	std::vector<char> binary(length);
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+	if (length <= 0)
+		return;
+
+	std::error_code ec;
+	std::filesystem::create_directories(App.cache_dir + "programs", ec);
+
+	const auto file_path = getFilePath(key.hash);
+	const auto temp_path = file_path + "." + std::to_string(GetCurrentThreadId());
+	{
+		std::ofstream file(temp_path, std::ios::binary);
+		if (!file.is_open())
+			return;
+
+		auto writeU32 = [&file](uint32_t value) { file.write((const char*)&value, sizeof(value)); };
+		auto writeBlock = [&file, &writeU32](const char* data, size_t size) {
+			writeU32((uint32_t)size);
+			file.write(data, size);
+		};
+
+		writeU32(PROGRAM_CACHE_MAGIC);
+		writeU32(PROGRAM_CACHE_VERSION);
+		writeBlock(key.defines.data(), key.defines.size());
+		writeBlock(key.source, strlen(key.source));
+		writeU32(format);
+		writeBlock(binary.data(), length);
+
+		file.close();
+		if (!file) {
+			std::filesystem::remove(temp_path, ec);
+			return;
+		}
+	}
+
+	std::filesystem::rename(temp_path, file_path, ec);
+	if (ec)
+		std::filesystem::remove(temp_path, ec);
+}
+
+const std::string& ProgramCache::getDriverString()
+{
+	static std::string driver = "";
+	if (driver.empty()) {
+		auto str = [](GLenum name) {
+			const auto value = (const char*)glGetString(name);
+			return std::string(value ? value : "");
+		};
+		driver = str(GL_VENDOR) + "|" + str(GL_RENDERER) + "|" + str(GL_VERSION);
+	}
+
+	return driver;
+}
+
+std::string ProgramCache::getFilePath(uint64_t key)
+{
+	char file_name[40] = { 0 };
+	sprintf_s(file_name, "%016llx.bin", key);
+
+	return App.cache_dir + "programs\\" + file_name;
+}
+
+}
@@ -0,0 +1,44 @@
+/*
+	D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+	Copyright (C) 2023  Bayaraa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// Bump when the stored layout changes. Driver updates are detected from the stored driver string.
+#define PROGRAM_CACHE_VERSION 2
+
+namespace d2gl {
+
+// The hash only names the file, the defines and source are stored in it and compared on load.
+struct ProgramCacheKey {
+	uint64_t hash = 0;
+	std::string defines;
+	const char* source = nullptr;
+};
+
+class ProgramCache {
+public:
+	static ProgramCacheKey getKey(const char* source, glm::vec<2, uint8_t> version, bool compute);
+	static bool load(const ProgramCacheKey& key, GLuint program);
+	static void save(const ProgramCacheKey& key, GLuint program);
+
+private:
+	static const std::string& getDriverString();
+	static std::string getFilePath(uint64_t key);
+};
+
+}
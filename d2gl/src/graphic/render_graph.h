@@ -0,0 +1,190 @@
+/*
+D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+Copyright (C) 2023  Bayaraa
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Kept free of GL so the compiler can be exercised offline, see tools/render_graph_eval.
+
+#define RENDER_GRAPH_NONE UINT32_MAX
+
+namespace d2gl {
+
+struct RenderTargetDesc {
+	uint32_t width = 0;
+	uint32_t height = 0;
+	uint32_t format = 0;
+
+	inline bool operator==(const RenderTargetDesc& other) const { return width == other.width && height == other.height && format == other.format; }
+};
+
+struct RenderGraphPass {
+	uint32_t id = 0;              // caller defined, tells the executor what to run
+	std::vector<uint32_t> inputs; // physical targets once compiled
+	uint32_t output = RENDER_GRAPH_NONE;
+};
+
+struct PhysicalTarget {
+	RenderTargetDesc desc;
+	bool imported = false;
+	uint32_t external = 0;        // caller handle of an imported target
+	uint32_t index = 0;           // n-th transient target of this desc, lets graphs share pooled targets
+};
+
+class RenderGraph {
+	struct Target {
+		RenderTargetDesc desc;
+		bool imported = false;
+		uint32_t external = 0;
+		uint32_t writer = RENDER_GRAPH_NONE;
+		uint32_t last_use = 0;
+		uint32_t physical = RENDER_GRAPH_NONE;
+	};
+
+	std::vector<Target> m_targets;
+	std::vector<RenderGraphPass> m_passes;
+	std::vector<RenderGraphPass> m_compiled;
+	std::vector<PhysicalTarget> m_physical;
+
+public:
+	inline void clear()
+	{
+		m_targets.clear();
+		m_passes.clear();
+		m_compiled.clear();
+		m_physical.clear();
+	}
+
+	// Imported targets live outside of the graph (game frame buffer, screen), they are never aliased.
+	inline uint32_t importTarget(uint32_t external, const RenderTargetDesc& desc = {})
+	{
+		Target target;
+		target.desc = desc;
+		target.imported = true;
+		target.external = external;
+		m_targets.push_back(target);
+		return (uint32_t)m_targets.size() - 1;
+	}
+
+	inline uint32_t createTarget(const RenderTargetDesc& desc)
+	{
+		Target target;
+		target.desc = desc;
+		m_targets.push_back(target);
+		return (uint32_t)m_targets.size() - 1;
+	}
+
+	// Every transient target is written once, ping-pong chains declare a new target per step.
+	inline void addPass(uint32_t id, const std::vector<uint32_t>& inputs, uint32_t output) { m_passes.push_back({ id, inputs, output }); }
+
+	// Culls passes that do not contribute to an imported target and maps the remaining
+	// transient targets to as few physical targets as their lifetimes allow.
+	inline bool compile()
+	{
+		m_compiled.clear();
+		m_physical.clear();
+		for (auto& target : m_targets) {
+			target.writer = RENDER_GRAPH_NONE;
+			target.last_use = 0;
+			target.physical = RENDER_GRAPH_NONE;
+		}
+
+		const uint32_t pass_count = (uint32_t)m_passes.size();
+		for (uint32_t i = 0; i < pass_count; i++) {
+			auto& pass = m_passes[i];
+			if (pass.output >= m_targets.size())
+				return false;
+
+			for (auto input : pass.inputs) {
+				if (input >= m_targets.size() || input == pass.output)
+					return false;
+				if (!m_targets[input].imported && m_targets[input].writer >= i)
+					return false;
+			}
+
+			auto& output = m_targets[pass.output];
+			if (!output.imported && output.writer != RENDER_GRAPH_NONE)
+				return false;
+			output.writer = i;
+		}
+
+		std::vector<bool> live(pass_count, false);
+		std::vector<bool> needed(m_targets.size(), false);
+		for (uint32_t i = pass_count; i-- > 0;) {
+			const auto& pass = m_passes[i];
+			if (!m_targets[pass.output].imported && !needed[pass.output])
+				continue;
+
+			live[i] = true;
+			for (auto input : pass.inputs) {
+				needed[input] = true;
+				m_targets[input].last_use = m_targets[input].last_use > i ? m_targets[input].last_use : i;
+			}
+		}
+
+		std::vector<uint32_t> busy_until;
+		for (uint32_t i = 0; i < pass_count; i++) {
+			if (!live[i])
+				continue;
+
+			const auto& pass = m_passes[i];
+			RenderGraphPass compiled = { pass.id, {}, RENDER_GRAPH_NONE };
+			for (auto input : pass.inputs)
+				compiled.inputs.push_back(getPhysical(input, i, busy_until));
+			compiled.output = getPhysical(pass.output, i, busy_until);
+			m_compiled.push_back(compiled);
+		}
+
+		return true;
+	}
+
+	inline const std::vector<RenderGraphPass>& getPasses() const { return m_compiled; }
+	inline const std::vector<PhysicalTarget>& getPhysicalTargets() const { return m_physical; }
+
+private:
+	inline uint32_t getPhysical(uint32_t target_index, uint32_t pass_index, std::vector<uint32_t>& busy_until)
+	{
+		auto& target = m_targets[target_index];
+		if (target.physical != RENDER_GRAPH_NONE)
+			return target.physical;
+
+		if (!target.imported) {
+			// A physical target is free again once the last pass reading its previous content ran.
+			for (uint32_t i = 0; i < m_physical.size(); i++) {
+				if (!m_physical[i].imported && m_physical[i].desc == target.desc && busy_until[i] < pass_index) {
+					busy_until[i] = target.last_use;
+					target.physical = i;
+					return i;
+				}
+			}
+		}
+
+		PhysicalTarget physical = { target.desc, target.imported, target.external };
+		for (auto& other : m_physical)
+			physical.index += !other.imported && !target.imported && other.desc == target.desc;
+		m_physical.push_back(physical);
+		busy_until.push_back(target.imported ? UINT32_MAX : target.last_use);
+
+		target.physical = (uint32_t)m_physical.size() - 1;
+		return target.physical;
+	}
+};
+
+}
@@ -0,0 +1,179 @@
+/*
+	D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+	Copyright (C) 2023  Bayaraa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "resource_pool.h"
+#include "context.h"
+
+namespace d2gl {
+
+void ResourcePool::acquire(std::unique_ptr<FrameBuffer>& frame_buffer, const FrameBufferCreateInfo& info)
+{
+	if (frame_buffer && isMatch(frame_buffer->getInfo(), info)) {
+		frame_buffer->reuse(info);
+		return;
+	}
+	release(frame_buffer);
+
+	for (size_t i = m_frame_buffers.size(); i-- > 0;) {
+		auto& entry = m_frame_buffers[i];
+		if (!isMatch(entry.info, info))
+			continue;
+
+		frame_buffer = std::move(entry.frame_buffer);
+		frame_buffer->reuse(info);
+		m_bytes -= entry.bytes;
+		m_frame_buffers.erase(m_frame_buffers.begin() + i);
+		m_stats.reused++;
+		return;
+	}
+
+	frame_buffer = Context::createFrameBuffer(info);
+	m_stats.created++;
+}
+
+void ResourcePool::acquire(std::unique_ptr<Texture>& texture, const TextureCreateInfo& info)
+{
+	if (texture && isMatch(texture->getInfo(), info)) {
+		texture->setSlot(info.slot);
+		return;
+	}
+	release(texture);
+
+	for (size_t i = m_textures.size(); i-- > 0;) {
+		auto& entry = m_textures[i];
+		if (!isMatch(entry.info, info))
+			continue;
+
+		texture = std::move(entry.texture);
+		texture->setSlot(info.slot);
+		m_bytes -= entry.bytes;
+		m_textures.erase(m_textures.begin() + i);
+		m_stats.reused++;
+		return;
+	}
+
+	texture = Context::createTexture(info);
+	m_stats.created++;
+}
+
+void ResourcePool::release(std::unique_ptr<FrameBuffer>& frame_buffer)
+{
+	if (!frame_buffer)
+		return;
+
+	if (!frame_buffer->isComplete()) {
+		frame_buffer.reset();
+		return;
+	}
+
+	const auto bytes = getBytes(frame_buffer->getInfo());
+	m_frame_buffers.push_back({ frame_buffer->getInfo(), std::move(frame_buffer), bytes, m_frame });
+	m_bytes += bytes;
+	trim(RESOURCE_POOL_MAX_BYTES, RESOURCE_POOL_MAX_AGE, 0);
+}
+
+void ResourcePool::release(std::unique_ptr<Texture>& texture)
+{
+	if (!texture)
+		return;
+
+	// Only plain 2D textures are shared, their content is never relied on.
+	const auto& info = texture->getInfo();
+	if (info.layer_count != 1 || info.mip_map) {
+		texture.reset();
+		return;
+	}
+
+	const auto bytes = getBytes(info);
+	m_textures.push_back({ info, std::move(texture), bytes, m_frame });
+	m_bytes += bytes;
+	trim(RESOURCE_POOL_MAX_BYTES, RESOURCE_POOL_MAX_AGE, 0);
+}
+
+void ResourcePool::endFrame()
+{
+	m_frame++;
+	trim(RESOURCE_POOL_MAX_BYTES, RESOURCE_POOL_MAX_AGE, 1);
+}
+
+void ResourcePool::clear()
+{
+	m_stats.deleted += getCount();
+	m_frame_buffers.clear();
+	m_textures.clear();
+	m_bytes = 0;
+}
+
+// Deletes the oldest entries first, everything over the size limit and up to max_count expired ones.
+void ResourcePool::trim(uint64_t max_bytes, uint64_t max_age, uint32_t max_count)
+{
+	while (getCount()) {
+		const bool fb_oldest = !m_frame_buffers.empty() && (m_textures.empty() || m_frame_buffers.front().released <= m_textures.front().released);
+		const uint64_t released = fb_oldest ? m_frame_buffers.front().released : m_textures.front().released;
+
+		if (m_bytes <= max_bytes) {
+			if (max_count == 0 || m_frame - released < max_age)
+				return;
+			max_count--;
+		}
+
+		if (fb_oldest) {
+			m_bytes -= m_frame_buffers.front().bytes;
+			m_frame_buffers.erase(m_frame_buffers.begin());
+		} else {
+			m_bytes -= m_textures.front().bytes;
+			m_textures.erase(m_textures.begin());
+		}
+		m_stats.deleted++;
+	}
+}
+
+bool ResourcePool::isMatch(const FrameBufferCreateInfo& a, const FrameBufferCreateInfo& b)
+{
+	if (a.size != b.size || a.attachments.size() != b.attachments.size())
+		return false;
+
+	for (size_t i = 0; i < a.attachments.size(); i++) {
+		if (a.attachments[i].format != b.attachments[i].format || a.attachments[i].filter != b.attachments[i].filter)
+			return false;
+	}
+
+	return true;
+}
+
+bool ResourcePool::isMatch(const TextureCreateInfo& a, const TextureCreateInfo& b)
+{
+	return a.size == b.size && a.format == b.format && a.filter == b.filter && a.wrap_mode == b.wrap_mode && a.layer_count == b.layer_count && a.mip_map == b.mip_map;
+}
+
+uint64_t ResourcePool::getBytes(const FrameBufferCreateInfo& info)
+{
+	uint64_t bytes = 0;
+	for (auto& attachment : info.attachments)
+		bytes += (uint64_t)info.size.x * info.size.y * (attachment.format.first == GL_R8 ? 1 : 4);
+
+	return bytes;
+}
+
+uint64_t ResourcePool::getBytes(const TextureCreateInfo& info)
+{
+	return (uint64_t)info.size.x * info.size.y * info.layer_count * (info.format.first == GL_R8 ? 1 : 4);
+}
+
+}
@@ -0,0 +1,88 @@
+/*
+	D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+	Copyright (C) 2023  Bayaraa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#include "frame_buffer.h"
+#include "texture.h"
+
+// Released resources kept for reuse, older ones are deleted one per frame.
+#define RESOURCE_POOL_MAX_AGE 1800
+#define RESOURCE_POOL_MAX_BYTES (256 * 1024 * 1024)
+
+namespace d2gl {
+
+struct PooledFrameBuffer {
+	FrameBufferCreateInfo info;
+	std::unique_ptr<FrameBuffer> frame_buffer;
+	uint64_t bytes = 0;
+	uint64_t released = 0;
+};
+
+struct PooledTexture {
+	TextureCreateInfo info;
+	std::unique_ptr<Texture> texture;
+	uint64_t bytes = 0;
+	uint64_t released = 0;
+};
+
+struct ResourcePoolStats {
+	uint32_t reused = 0;
+	uint32_t created = 0;
+	uint32_t deleted = 0;
+};
+
+class ResourcePool {
+	std::vector<PooledFrameBuffer> m_frame_buffers;
+	std::vector<PooledTexture> m_textures;
+	uint64_t m_bytes = 0;
+	uint64_t m_frame = 0;
+	ResourcePoolStats m_stats;
+
+	ResourcePool() = default;
+	~ResourcePool() = default;
+
+public:
+	static ResourcePool& Instance()
+	{
+		static ResourcePool instance;
+		return instance;
+	}
+
+	// Releases the current resource and hands back a matching one, reused when possible.
+	void acquire(std::unique_ptr<FrameBuffer>& frame_buffer, const FrameBufferCreateInfo& info);
+	void acquire(std::unique_ptr<Texture>& texture, const TextureCreateInfo& info);
+	void release(std::unique_ptr<FrameBuffer>& frame_buffer);
+	void release(std::unique_ptr<Texture>& texture);
+
+	void endFrame();
+	void clear();
+
+	inline uint32_t getCount() const { return m_frame_buffers.size() + m_textures.size(); }
+	inline uint64_t getBytes() const { return m_bytes; }
+	inline const ResourcePoolStats& getStats() const { return m_stats; }
+
+private:
+	void trim(uint64_t max_bytes, uint64_t max_age, uint32_t max_count);
+
+	static bool isMatch(const FrameBufferCreateInfo& a, const FrameBufferCreateInfo& b);
+	static bool isMatch(const TextureCreateInfo& a, const TextureCreateInfo& b);
+	static uint64_t getBytes(const FrameBufferCreateInfo& info);
+	static uint64_t getBytes(const TextureCreateInfo& info);
+};
+
+}
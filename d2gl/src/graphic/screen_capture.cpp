@@ -0,0 +1,409 @@
+/*
+	D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+	Copyright (C) 2023  Bayaraa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "screen_capture.h"
+#include "gl_state.h"
+#include "helpers.h"
+
+namespace d2gl {
+
+// BT.601 full range, matches the C420jpeg tag of the stream header.
+static void convertToYuv420(const uint8_t* bgra, glm::uvec2 size, std::vector<uint8_t>& planes)
+{
+	const uint32_t chroma_width = (size.x + 1) / 2;
+	const uint32_t chroma_height = (size.y + 1) / 2;
+	planes.resize((size_t)size.x * size.y + (size_t)chroma_width * chroma_height * 2);
+
+	uint8_t* y_plane = planes.data();
+	uint8_t* u_plane = y_plane + (size_t)size.x * size.y;
+	uint8_t* v_plane = u_plane + (size_t)chroma_width * chroma_height;
+	auto getPixel = [&](uint32_t x, uint32_t y) { return bgra + ((size_t)(size.y - 1 - y) * size.x + x) * 4; };
+
+	for (uint32_t y = 0; y < size.y; y++) {
+		for (uint32_t x = 0; x < size.x; x++) {
+			const uint8_t* p = getPixel(x, y);
+			y_plane[(size_t)y * size.x + x] = (uint8_t)((29 * p[0] + 150 * p[1] + 77 * p[2] + 128) >> 8);
+		}
+	}
+
+	for (uint32_t y = 0; y < chroma_height; y++) {
+		for (uint32_t x = 0; x < chroma_width; x++) {
+			const uint32_t x1 = std::min(x * 2 + 1, size.x - 1);
+			const uint32_t y1 = std::min(y * 2 + 1, size.y - 1);
+			const uint8_t* p[4] = { getPixel(x * 2, y * 2), getPixel(x1, y * 2), getPixel(x * 2, y1), getPixel(x1, y1) };
+			const int b = (p[0][0] + p[1][0] + p[2][0] + p[3][0] + 2) / 4;
+			const int g = (p[0][1] + p[1][1] + p[2][1] + p[3][1] + 2) / 4;
+			const int r = (p[0][2] + p[1][2] + p[2][2] + p[3][2] + 2) / 4;
+			u_plane[(size_t)y * chroma_width + x] = (uint8_t)glm::clamp(128 + (-43 * r - 85 * g + 128 * b) / 256, 0, 255);
+			v_plane[(size_t)y * chroma_width + x] = (uint8_t)glm::clamp(128 + (128 * r - 107 * g - 21 * b) / 256, 0, 255);
+		}
+	}
+}
+
+void ScreenCapture::takeScreenShot()
+{
+	const uint32_t tick_count = GetTickCount();
+	if (m_last_tick > tick_count - 1000)
+		return;
+
+	CaptureReadback* readback = nullptr;
+	for (auto& r : m_readbacks) {
+		if (!r.fence) {
+			readback = &r;
+			break;
+		}
+	}
+	if (!readback)
+		return;
+
+	auto& state = GLState::Instance();
+	if (!readback->buffer)
+		glGenBuffers(1, &readback->buffer);
+
+	const glm::uvec2 size = App.viewport.size;
+	state.bindBuffer(GL_PIXEL_PACK_BUFFER, readback->buffer);
+	if (readback->size != size) {
+		glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)size.x * size.y * 4, nullptr, GL_STREAM_READ);
+		readback->size = size;
+	}
+
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(App.viewport.offset.x, App.viewport.offset.y, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+	state.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	readback->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readback->frames = 0;
+	m_last_tick = tick_count;
+}
+
+void ScreenCapture::update()
+{
+	auto& state = GLState::Instance();
+	for (auto& readback : m_readbacks) {
+		if (!readback.fence)
+			continue;
+
+		// Mapping before the copy finished would stall, it is only forced after a few frames.
+		if (readback.frames++ < SCREEN_CAPTURE_MAX_DELAY && glClientWaitSync(readback.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+			continue;
+
+		glDeleteSync(readback.fence);
+		readback.fence = 0;
+
+		const size_t size = (size_t)readback.size.x * readback.size.y * 4;
+		state.bindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+		if (auto data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT)) {
+			CaptureJob job = { std::vector<uint8_t>((const uint8_t*)data, (const uint8_t*)data + size), readback.size };
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			pushJob(std::move(job));
+		}
+		state.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+
+	if (m_writer.joinable())
+		updateRecording();
+}
+
+void ScreenCapture::destroy()
+{
+	if (m_writer.joinable()) {
+		m_recording = false;
+		finishRecording();
+	}
+
+	auto& state = GLState::Instance();
+	for (auto& readback : m_readbacks) {
+		if (readback.fence)
+			glDeleteSync(readback.fence);
+		if (readback.buffer) {
+			state.onDeleteBuffer(readback.buffer);
+			glDeleteBuffers(1, &readback.buffer);
+		}
+		readback = {};
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_condition.notify_one();
+	if (m_worker.joinable())
+		m_worker.join();
+}
+
+bool ScreenCapture::startRecording(CaptureFormat format, uint32_t interval)
+{
+	if (isRecording())
+		return false;
+
+	m_record_size = App.viewport.size;
+	m_record_offset = App.viewport.offset;
+
+	auto& state = GLState::Instance();
+	for (auto& slot : m_slots) {
+		glGenBuffers(1, &slot.buffer);
+		state.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)m_record_size.x * m_record_size.y * 4, nullptr, GL_STREAM_READ);
+		slot.state = CaptureSlotState::Free;
+	}
+	state.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+	m_record_start = counter.QuadPart;
+	m_frequency = (double)frequency.QuadPart / 1000.0;
+
+	m_format = format;
+	m_interval = interval > 0 ? interval : 1;
+	const double frame_time = App.context->getAvgFrameTime() * m_interval;
+	m_frame_rate = frame_time > 0.0 ? 1000.0 / frame_time : 60.0;
+	m_frame = 0;
+	m_push_index = 0;
+	m_map_index = 0;
+	m_dropped = 0;
+	m_written = 0;
+	m_writer_stop = false;
+	m_record_semaphore = CreateSemaphore(NULL, 0, FRAME_CAPTURE_SLOTS + 1, NULL);
+	m_writer = std::thread(&ScreenCapture::writer, this);
+	m_recording = true;
+
+	trace_log("Frame capture started (%u x %u, every %u frame).", m_record_size.x, m_record_size.y, m_interval);
+	return true;
+}
+
+void ScreenCapture::stopRecording()
+{
+	m_recording = false;
+}
+
+void ScreenCapture::captureFrame()
+{
+	if (!m_recording)
+		return;
+
+	if (App.viewport.size != m_record_size || App.viewport.offset != m_record_offset) {
+		trace_log("Frame capture stopped, viewport changed.");
+		stopRecording();
+		return;
+	}
+
+	if (m_frame++ % m_interval)
+		return;
+
+	auto& slot = m_slots[m_push_index % FRAME_CAPTURE_SLOTS];
+	if (slot.state != CaptureSlotState::Free) {
+		m_dropped++;
+		return;
+	}
+
+	auto& state = GLState::Instance();
+	state.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(m_record_offset.x, m_record_offset.y, m_record_size.x, m_record_size.y, GL_BGRA, GL_UNSIGNED_BYTE, 0);
+	state.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	slot.frame = m_frame - 1;
+	slot.time_ms = (double)(counter.QuadPart - m_record_start) / m_frequency;
+	slot.state = CaptureSlotState::Reading;
+	m_push_index++;
+}
+
+void ScreenCapture::updateRecording()
+{
+	auto& state = GLState::Instance();
+
+	// Slots go through the ring in order, the first unfinished read back ends the scan.
+	for (uint32_t i = 0; i < FRAME_CAPTURE_SLOTS; i++) {
+		auto& slot = m_slots[m_map_index % FRAME_CAPTURE_SLOTS];
+		if (slot.state != CaptureSlotState::Reading || glClientWaitSync(slot.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+			break;
+
+		glDeleteSync(slot.fence);
+		slot.fence = 0;
+
+		state.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		slot.data = (const uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)m_record_size.x * m_record_size.y * 4, GL_MAP_READ_BIT);
+		if (slot.data) {
+			slot.state = CaptureSlotState::Queued;
+			ReleaseSemaphore(m_record_semaphore, 1, NULL);
+		} else {
+			slot.state = CaptureSlotState::Free;
+			m_dropped++;
+		}
+		m_map_index++;
+	}
+
+	bool idle = true;
+	for (auto& slot : m_slots) {
+		if (slot.state == CaptureSlotState::Written) {
+			state.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+			slot.data = nullptr;
+			slot.state = CaptureSlotState::Free;
+		}
+		idle &= slot.state == CaptureSlotState::Free;
+	}
+	state.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if (!m_recording && idle)
+		finishRecording();
+}
+
+// Lets the writer drain what is queued, read backs still in flight are dropped.
+void ScreenCapture::finishRecording()
+{
+	m_writer_stop = true;
+	ReleaseSemaphore(m_record_semaphore, 1, NULL);
+	m_writer.join();
+	CloseHandle(m_record_semaphore);
+	m_record_semaphore = NULL;
+
+	auto& state = GLState::Instance();
+	for (auto& slot : m_slots) {
+		if (slot.fence)
+			glDeleteSync(slot.fence);
+		if (slot.data) {
+			state.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		state.onDeleteBuffer(slot.buffer);
+		glDeleteBuffers(1, &slot.buffer);
+
+		slot.buffer = 0;
+		slot.fence = 0;
+		slot.data = nullptr;
+		slot.state = CaptureSlotState::Free;
+	}
+	state.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	trace_log("Frame capture finished, %u frames written, %u dropped.", (uint32_t)m_written, m_dropped);
+}
+
+void ScreenCapture::writer()
+{
+	char file_name[30] = { 0 };
+	for (size_t i = 1; i < 999; i++) {
+		sprintf_s(file_name, "Capture%03d.txt", i);
+		if (!helpers::fileExists(file_name))
+			break;
+	}
+	std::string base_name = file_name;
+	base_name.resize(base_name.size() - 4);
+
+	const bool y4m = m_format == CaptureFormat::Y4M;
+	std::ofstream video(base_name + (y4m ? ".y4m" : ".bgra"), std::ios::binary);
+	std::ofstream index(base_name + ".txt");
+
+	// The rate starts as an estimate and is rewritten from the capture times once done. Fixed width
+	// fields keep the header size, y4m readers parse the zero padded numbers as is.
+	char line[128] = { 0 };
+	auto writeHeader = [&](double frame_rate) {
+		sprintf_s(line, "YUV4MPEG2 W%u H%u F%010u:1000 Ip A1:1 C420jpeg\n", m_record_size.x, m_record_size.y, (uint32_t)(frame_rate * 1000.0 + 0.5));
+		video << line;
+	};
+	if (y4m)
+		writeHeader(m_frame_rate);
+	sprintf_s(line, "# %s %ux%u, frame time_ms\n", y4m ? "y4m" : "bgra", m_record_size.x, m_record_size.y);
+	index << line;
+
+	std::vector<uint8_t> planes;
+	uint32_t slot_index = 0;
+	uint32_t frame_count = 0;
+	double first_time = 0.0, last_time = 0.0;
+	while (true) {
+		WaitForSingleObject(m_record_semaphore, INFINITE);
+
+		auto& slot = m_slots[slot_index % FRAME_CAPTURE_SLOTS];
+		if (slot.state != CaptureSlotState::Queued) {
+			if (m_writer_stop)
+				break;
+			continue;
+		}
+
+		const size_t row_size = (size_t)m_record_size.x * 4;
+		if (y4m) {
+			convertToYuv420(slot.data, m_record_size, planes);
+			video << "FRAME\n";
+			video.write((const char*)planes.data(), planes.size());
+		} else {
+			for (uint32_t y = m_record_size.y; y-- > 0;)
+				video.write((const char*)slot.data + y * row_size, row_size);
+		}
+
+		sprintf_s(line, "%llu %.3f\n", slot.frame, slot.time_ms);
+		index << line;
+
+		if (frame_count++ == 0)
+			first_time = slot.time_ms;
+		last_time = slot.time_ms;
+
+		slot.state = CaptureSlotState::Written;
+		slot_index++;
+		m_written++;
+	}
+
+	if (y4m && frame_count > 1 && last_time > first_time) {
+		video.seekp(0);
+		writeHeader((frame_count - 1) * 1000.0 / (last_time - first_time));
+	}
+}
+
+void ScreenCapture::pushJob(CaptureJob&& job)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_stop)
+		return;
+
+	if (!m_worker.joinable())
+		m_worker = std::thread(&ScreenCapture::worker, this);
+
+	m_jobs.push_back(std::move(job));
+	m_condition.notify_one();
+}
+
+void ScreenCapture::worker()
+{
+	while (true) {
+		CaptureJob job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+			if (m_jobs.empty())
+				return;
+
+			job = std::move(m_jobs.front());
+			m_jobs.pop_front();
+		}
+
+		const size_t pixel_count = (size_t)job.size.x * job.size.y;
+		for (size_t i = 0; i < pixel_count; i++) {
+			job.pixels[i * 3 + 0] = job.pixels[i * 4 + 0];
+			job.pixels[i * 3 + 1] = job.pixels[i * 4 + 1];
+			job.pixels[i * 3 + 2] = job.pixels[i * 4 + 2];
+		}
+
+		helpers::saveScreenShot(job.pixels.data(), job.size.x, job.size.y);
+	}
+}
+
+}
@@ -0,0 +1,121 @@
+/*
+	D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+	Copyright (C) 2023  Bayaraa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+#pragma once
+
+#define SCREEN_CAPTURE_READBACKS 2
+#define SCREEN_CAPTURE_MAX_DELAY 3
+#define FRAME_CAPTURE_SLOTS 4
+
+namespace d2gl {
+
+struct CaptureReadback {
+	GLuint buffer = 0;
+	GLsync fence = 0;
+	glm::uvec2 size = { 0, 0 };
+	uint32_t frames = 0;
+};
+
+enum class CaptureFormat {
+	Y4M,
+	Raw,
+};
+
+enum class CaptureSlotState {
+	Free,
+	Reading,
+	Queued,
+	Written,
+};
+
+// Owned by the render thread except while queued, the writer thread then reads the mapped data.
+struct CaptureSlot {
+	GLuint buffer = 0;
+	GLsync fence = 0;
+	const uint8_t* data = nullptr;
+	uint64_t frame = 0;
+	double time_ms = 0.0;
+	std::atomic<CaptureSlotState> state = CaptureSlotState::Free;
+};
+
+struct CaptureJob {
+	std::vector<uint8_t> pixels;
+	glm::uvec2 size = { 0, 0 };
+};
+
+class ScreenCapture {
+	CaptureReadback m_readbacks[SCREEN_CAPTURE_READBACKS];
+	uint32_t m_last_tick = 0;
+
+	std::deque<CaptureJob> m_jobs;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	std::thread m_worker;
+	bool m_stop = false;
+
+	CaptureSlot m_slots[FRAME_CAPTURE_SLOTS];
+	CaptureFormat m_format = CaptureFormat::Y4M;
+	glm::uvec2 m_record_size = { 0, 0 };
+	glm::ivec2 m_record_offset = { 0, 0 };
+	uint32_t m_interval = 1;
+	uint64_t m_frame = 0;
+	uint32_t m_push_index = 0;
+	uint32_t m_map_index = 0;
+	bool m_recording = false;
+	int64_t m_record_start = 0;
+	double m_frequency = 1.0;
+	double m_frame_rate = 60.0;
+	uint32_t m_dropped = 0;
+	std::atomic<uint32_t> m_written = 0;
+	std::atomic<bool> m_writer_stop = false;
+	HANDLE m_record_semaphore = NULL;
+	std::thread m_writer;
+
+	ScreenCapture() = default;
+	~ScreenCapture() = default;
+
+public:
+	static ScreenCapture& Instance()
+	{
+		static ScreenCapture instance;
+		return instance;
+	}
+
+	// Render thread only, the pixels are read back asynchronously and saved by a worker thread.
+	void takeScreenShot();
+	void update();
+	void destroy();
+
+	// Streams every interval-th presented frame, frames are dropped rather than waited for.
+	bool startRecording(CaptureFormat format, uint32_t interval);
+	void stopRecording();
+	void captureFrame();
+
+	inline bool isRecording() const { return m_recording || m_writer.joinable(); }
+	inline uint32_t getWrittenFrames() const { return m_written; }
+	inline uint32_t getDroppedFrames() const { return m_dropped; }
+
+private:
+	void pushJob(CaptureJob&& job);
+	void worker();
+
+	void updateRecording();
+	void finishRecording();
+	void writer();
+};
+
+}
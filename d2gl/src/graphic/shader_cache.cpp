@@ -0,0 +1,146 @@
+/*
+	D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+	Copyright (C) 2023  Bayaraa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "shader_cache.h"
+#include "helpers.h"
+
+namespace d2gl {
+
+#define SHADER_CACHE_MAGIC 0x43533244 // "D2SC"
+
+ShaderCacheKey ShaderCache::getKey(const std::string& vert_source, const std::string& frag_source)
+{
+	ShaderCacheKey key;
+	key.vert_source = vert_source.c_str();
+	key.frag_source = frag_source.c_str();
+
+	const uint32_t vert_hash = helpers::hash(vert_source.data(), vert_source.size());
+	const uint32_t frag_hash = helpers::hash(frag_source.data(), frag_source.size());
+	key.hash = ((uint64_t)vert_hash << 32) | frag_hash;
+
+	return key;
+}
+
+bool ShaderCache::load(const ShaderCacheKey& key, ShaderCacheEntry& entry)
+{
+	std::ifstream file(getFilePath(key.hash), std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return false;
+
+	const uint64_t file_size = (uint64_t)file.tellg();
+	file.seekg(0);
+
+	auto readU32 = [&file]() {
+		uint32_t value = 0;
+		file.read((char*)&value, sizeof(value));
+		return value;
+	};
+	// Lengths come from the file, a corrupt one must not turn into a huge allocation.
+	auto readStr = [&file, &readU32, file_size]() {
+		const uint32_t size = readU32();
+		if (!file || size > file_size - (uint64_t)file.tellg()) {
+			file.setstate(std::ios::failbit);
+			return std::string();
+		}
+		std::string str(size, '\0');
+		file.read(str.data(), str.size());
+		return str;
+	};
+
+	if (readU32() != SHADER_CACHE_MAGIC || readU32() != SHADER_CACHE_VERSION)
+		return false;
+
+	if (readStr() != key.vert_source || !file || readStr() != key.frag_source || !file)
+		return false;
+
+	entry.source = readStr();
+
+	const uint32_t sampler_count = readU32();
+	for (uint32_t i = 0; i < sampler_count && file; i++)
+		entry.samplers.push_back(readStr());
+
+	const uint32_t uniform_count = readU32();
+	for (uint32_t i = 0; i < uniform_count && file; i++) {
+		auto name = readStr();
+		entry.uniforms[name] = readStr();
+	}
+
+	if (!file) {
+		entry = {};
+		return false;
+	}
+
+	return true;
+}
+
+void ShaderCache::save(const ShaderCacheKey& key, const ShaderCacheEntry& entry)
+{
+	std::error_code ec;
+	std::filesystem::create_directories(App.cache_dir + "shaders", ec);
+
+	const auto file_path = getFilePath(key.hash);
+	const auto temp_path = file_path + "." + std::to_string(GetCurrentThreadId());
+	{
+		std::ofstream file(temp_path, std::ios::binary);
+		if (!file.is_open())
+			return;
+
+		auto writeU32 = [&file](uint32_t value) { file.write((const char*)&value, sizeof(value)); };
+		auto writeStr = [&file, &writeU32](const std::string& str) {
+			writeU32((uint32_t)str.size());
+			file.write(str.data(), str.size());
+		};
+
+		writeU32(SHADER_CACHE_MAGIC);
+		writeU32(SHADER_CACHE_VERSION);
+		writeStr(key.vert_source);
+		writeStr(key.frag_source);
+		writeStr(entry.source);
+
+		writeU32((uint32_t)entry.samplers.size());
+		for (auto& sampler : entry.samplers)
+			writeStr(sampler);
+
+		writeU32((uint32_t)entry.uniforms.size());
+		for (auto& uniform : entry.uniforms) {
+			writeStr(uniform.first);
+			writeStr(uniform.second);
+		}
+
+		file.close();
+		if (!file) {
+			std::filesystem::remove(temp_path, ec);
+			return;
+		}
+	}
+
+	std::filesystem::rename(temp_path, file_path, ec);
+	if (ec)
+		std::filesystem::remove(temp_path, ec);
+}
+
+std::string ShaderCache::getFilePath(uint64_t key)
+{
+	char file_name[40] = { 0 };
+	sprintf_s(file_name, "%016llx_%d%d.bin", key, App.gl_ver.x, App.gl_ver.y);
+
+	return App.cache_dir + "shaders\\" + file_name;
+}
+
+}
@@ -0,0 +1,49 @@
+/*
+	D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+	Copyright (C) 2023  Bayaraa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// Bump when the bundled glslang library or the emitted source layout changes.
+#define SHADER_CACHE_VERSION 2
+
+namespace d2gl {
+
+struct ShaderCacheEntry {
+	std::string source;
+	std::vector<std::string> samplers;
+	std::unordered_map<std::string, std::string> uniforms;
+};
+
+// The hash only names the file, both preprocessed sources are stored in it and compared on load.
+struct ShaderCacheKey {
+	uint64_t hash = 0;
+	const char* vert_source = nullptr;
+	const char* frag_source = nullptr;
+};
+
+class ShaderCache {
+public:
+	static ShaderCacheKey getKey(const std::string& vert_source, const std::string& frag_source);
+	static bool load(const ShaderCacheKey& key, ShaderCacheEntry& entry);
+	static void save(const ShaderCacheKey& key, const ShaderCacheEntry& entry);
+
+private:
+	static std::string getFilePath(uint64_t key);
+};
+
+}
@@ -19,12 +19,13 @@
 #ifdef VERTEX
 
 layout(location = 0) in vec2 Position;
-layout(location = 1) in vec2 TexCoord;
-layout(location = 2) in vec4 Color1;
-layout(location = 3) in vec4 Color2;
-layout(location = 4) in ivec2 TexIds;
-layout(location = 5) in uvec4 Flags;
-layout(location = 6) in vec2 Extra;
+layout(location = 1) in vec2 Size;
+layout(location = 2) in vec4 TexCoord;
+layout(location = 3) in vec4 Color1;
+layout(location = 4) in vec4 Color2;
+layout(location = 5) in ivec2 TexIds;
+layout(location = 6) in uvec4 Flags;
+layout(location = 7) in vec4 Extra;
 
 uniform mat4 u_MVP;
 
@@ -34,13 +35,16 @@ out vec4 v_Color1;
 out vec4 v_Color2;
 flat out ivec2 v_TexIds;
 flat out uvec4 v_Flags;
-out vec2 v_Extra;
+out vec4 v_Extra;
+
+const vec2 corners[4] = vec2[4](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));
 
 void main()
 {
-	v_Position = u_MVP * vec4(Position, 0.0, 1.0);
+	vec2 corner = corners[gl_VertexID];
+	v_Position = u_MVP * vec4(Position + Size * corner, 0.0, 1.0);
 	gl_Position = v_Position;
-	v_TexCoord = TexCoord;
+	v_TexCoord = vec2(mix(TexCoord.x, TexCoord.z, corner.x), mix(TexCoord.w, TexCoord.y, corner.y));
 	v_Color1 = Color1.abgr;
 	v_Color2 = Color2.abgr;
 	v_TexIds = TexIds;
@@ -64,7 +68,7 @@ in vec4 v_Color1;
 in vec4 v_Color2;
 flat in ivec2 v_TexIds;
 flat in uvec4 v_Flags;
-in vec2 v_Extra;
+in vec4 v_Extra;
 
 uniform vec2 u_Scale;
 uniform vec4 u_TextMask;
@@ -79,6 +83,16 @@ float msdf(vec3 rgb, float smoothess, float weight)
 	return clamp(screen_px_dist + 0.5, 0.0, 1.0);
 }
 
+float textAlpha(float alpha)
+{
+	if (u_IsMasking && v_Flags.z == 0u) {
+		if (u_TextMask.x < v_Position.x && u_TextMask.z > v_Position.x && u_TextMask.y > v_Position.y && u_TextMask.w < v_Position.y)
+			return 0.0;
+		return alpha * 0.7;
+	}
+	return alpha * v_Color2.a;
+}
+
 vec3 greyscale(vec3 color, float str)
 {
     float g = dot(color, vec3(0.299, 0.587, 0.114));
@@ -92,28 +106,26 @@ void main()
 		case 2u: FragColor = v_Color1; break;
 		case 3u: {
 			vec4 color = texture(u_FontTexture, vec3(v_TexCoord, v_TexIds.x));
-			if(v_Flags.y > 0u) {
-				float mlt = v_Flags.y == 1u ? 1.0 : 0.5;
-				FragColor = vec4((v_Color1.r + v_Color1.g + v_Color1.b) < 0.1 ? 0.8 : 0.0);
-				FragColor.a = (color.a < 0.26 ? 0.0 : smoothstep(0.0, 1.0, color.a)) * mlt * v_Extra.x;
+			if (v_Flags.w == 1u) {
+				float opacity1 = msdf(color.rgb, v_Extra.x, v_Extra.y + 0.02);
+				float opacity2 = msdf(color.rgb, v_Extra.x, 1.01);
+				FragColor = vec4(mix(v_Color2.rgb, v_Color1.rgb, opacity2), v_Color1.a * opacity1);
 			} else {
-				if (v_Flags.w == 1u) {
-					float opacity1 = msdf(color.rgb, v_Extra.x, v_Extra.y + 0.02);
-					float opacity2 = msdf(color.rgb, v_Extra.x, 1.01);
-					FragColor = vec4(mix(v_Color2.rgb, v_Color1.rgb, opacity2), v_Color1.a * opacity1);
-				} else {
-					float scale = smoothstep(1.5, 1.0, u_Scale.x);
-					float opacity = msdf(color.rgb, v_Extra.x / (1.0 + scale), v_Extra.y);
-					FragColor = vec4(v_Color1.rgb, v_Color1.a * opacity * (1.0 + 0.20 * scale));
-				}
+				float scale = smoothstep(1.5, 1.0, u_Scale.x);
+				float opacity = msdf(color.rgb, v_Extra.x / (1.0 + scale), v_Extra.y);
+				FragColor = vec4(v_Color1.rgb, v_Color1.a * opacity * (1.0 + 0.20 * scale));
 			}
-			if (u_IsMasking && v_Flags.z == 0u) {
-				if (u_TextMask.x < v_Position.x && u_TextMask.z > v_Position.x && u_TextMask.y > v_Position.y && u_TextMask.w < v_Position.y)
-					FragColor.a = 0.0;
-				else
-					FragColor.a *= 0.7;
-			} else {
-				FragColor.a *= v_Color2.a;
+			FragColor.a = textAlpha(FragColor.a);
+
+			// Shadow is composited under the glyph as if it was drawn first with the same blend mode.
+			if (v_Flags.y > 0u) {
+				float mlt = v_Flags.y == 1u ? 1.0 : 0.5;
+				vec3 shadow = vec3((v_Color1.r + v_Color1.g + v_Color1.b) < 0.1 ? 0.8 : 0.0);
+				float shadow_alpha = textAlpha((color.a < 0.26 ? 0.0 : smoothstep(0.0, 1.0, color.a)) * mlt * v_Extra.z);
+				float alpha = FragColor.a + shadow_alpha * (1.0 - FragColor.a);
+				if (alpha > 0.0)
+					FragColor.rgb = (FragColor.rgb * FragColor.a + shadow * shadow_alpha * (1.0 - FragColor.a)) / alpha;
+				FragColor.a = alpha;
 			}
 		}
 		break;
@@ -2,24 +2,27 @@
 
 "#ifdef VERTEX\n"
 "layout(location=0) in vec2 Position;"
-"layout(location=1) in vec2 TexCoord;"
-"layout(location=2) in vec4 Color1;"
-"layout(location=3) in vec4 Color2;"
-"layout(location=4) in ivec2 TexIds;"
-"layout(location=5) in uvec4 Flags;"
-"layout(location=6) in vec2 Extra;"
+"layout(location=1) in vec2 Size;"
+"layout(location=2) in vec4 TexCoord;"
+"layout(location=3) in vec4 Color1;"
+"layout(location=4) in vec4 Color2;"
+"layout(location=5) in ivec2 TexIds;"
+"layout(location=6) in uvec4 Flags;"
+"layout(location=7) in vec4 Extra;"
 "uniform mat4 u_MVP;"
 "out vec4 v_Position;"
 "out vec2 v_TexCoord;"
 "out vec4 v_Color1,v_Color2;"
 "flat out ivec2 v_TexIds;"
 "flat out uvec4 v_Flags;"
-"out vec2 v_Extra;"
+"out vec4 v_Extra;"
+"const vec2 v[4]=vec2[4](vec2(0),vec2(1,0),vec2(1),vec2(0,1));"
 "void main()"
 "{"
-  "v_Position=u_MVP*vec4(Position,0,1);"
+  "vec2 r=v[gl_VertexID];"
+  "v_Position=u_MVP*vec4(Position+Size*r,0,1);"
   "gl_Position=v_Position;"
-  "v_TexCoord=TexCoord;"
+  "v_TexCoord=vec2(mix(TexCoord.x,TexCoord.z,r.x),mix(TexCoord.w,TexCoord.y,r.y));"
   "v_Color1=Color1.wzyx;"
   "v_Color2=Color2.wzyx;"
   "v_TexIds=TexIds;"
@@ -36,7 +39,7 @@
 "in vec4 v_Color1,v_Color2;"
 "flat in ivec2 v_TexIds;"
 "flat in uvec4 v_Flags;"
-"in vec2 v_Extra;"
+"in vec4 v_Extra;"
 "uniform vec2 u_Scale;"
 "uniform vec4 u_TextMask,u_Viewport;"
 "uniform bool u_IsMasking=false,u_IsGlide=true;"
@@ -45,6 +48,16 @@
   "float r=max(min(v.x,v.y),min(max(v.x,v.y),v.z)),n=max(u,1.)*(r-1.+.5*y);"
   "return clamp(n+.5,0.,1.);"
 "}"
+"float v(float v)"
+"{"
+  "if(u_IsMasking&&v_Flags.z==0u)"
+    "{"
+      "if(u_TextMask.x<v_Position.x&&u_TextMask.z>v_Position.x&&u_TextMask.y>v_Position.y&&u_TextMask.w<v_Position.y)"
+        "return 0.;"
+      "return v*.7;"
+    "}"
+  "return v*v_Color2.w;"
+"}"
 "vec3 v(vec3 v,float u)"
 "{"
   "float y=dot(v,vec3(.299,.587,.114));"
@@ -62,36 +75,32 @@
     "case 3u:"
       "{"
         "vec4 d=texture(u_FontTexture,vec3(v_TexCoord,v_TexIds.x));"
+        "if(v_Flags.w==1u)"
+          "{"
+            "float y=v(d.xyz,v_Extra.x,v_Extra.y+.02),r=v(d.xyz,v_Extra.x,1.01);"
+            "FragColor=vec4(mix(v_Color2.xyz,v_Color1.xyz,r),v_Color1.w*y);"
+          "}"
+        "else "
+          "{"
+            "float y=smoothstep(1.5,1.,u_Scale.x),r=v(d.xyz,v_Extra.x/(1.+y),v_Extra.y);"
+            "FragColor=vec4(v_Color1.xyz,v_Color1.w*r*(1.+.2*y));"
+          "}"
+        "FragColor.w=v(FragColor.w);"
         "if(v_Flags.y>0u)"
           "{"
             "float r=v_Flags.y==1u?"
               "1.:"
               ".5;"
-            "FragColor=vec4(v_Color1.x+v_Color1.y+v_Color1.z<.1?"
+            "vec3 s=vec3(v_Color1.x+v_Color1.y+v_Color1.z<.1?"
               ".8:"
               "0.);"
-            "FragColor.w=(d.w<.26?"
+            "float n=v((d.w<.26?"
               "0.:"
-              "smoothstep(0.,1.,d.w))*r*v_Extra.x;"
+              "smoothstep(0.,1.,d.w))*r*v_Extra.z),y=FragColor.w+n*(1.-FragColor.w);"
+            "if(y>0.)"
+              "FragColor.xyz=(FragColor.xyz*FragColor.w+s*n*(1.-FragColor.w))/y;"
+            "FragColor.w=y;"
           "}"
-        "else "
-           "if(v_Flags.w==1u)"
-            "{"
-              "float y=v(d.xyz,v_Extra.x,v_Extra.y+.02),r=v(d.xyz,v_Extra.x,1.01);"
-              "FragColor=vec4(mix(v_Color2.xyz,v_Color1.xyz,r),v_Color1.w*y);"
-            "}"
-          "else "
-            "{"
-              "float y=smoothstep(1.5,1.,u_Scale.x),r=v(d.xyz,v_Extra.x/(1.+y),v_Extra.y);"
-              "FragColor=vec4(v_Color1.xyz,v_Color1.w*r*(1.+.2*y));"
-            "}"
-        "if(u_IsMasking&&v_Flags.z==0u)"
-          "if(u_TextMask.x<v_Position.x&&u_TextMask.z>v_Position.x&&u_TextMask.y>v_Position.y&&u_TextMask.w<v_Position.y)"
-            "FragColor.w=0.;"
-          "else "
-             "FragColor.w*=.7;"
-        "else "
-           "FragColor.w*=v_Color2.w;"
       "}"
       "break;"
     "case 4u:"
@@ -19,15 +19,13 @@
 #include "pch.h"
 #include "texture.h"
 #include "frame_buffer.h"
+#include "gl_state.h"
 
 namespace d2gl {
 
-uint32_t active_texture_slot = UINT32_MAX;
-GLuint current_binded_texture[32] = { UINT32_MAX };
-
 Texture::Texture(const TextureCreateInfo& info)
 	: m_width(info.size.x), m_height(info.size.y), m_layer_count(info.layer_count), m_internal_format(info.format.first), m_format(info.format.second),
-	  m_slot(info.slot), m_target(info.layer_count == 1 ? GL_TEXTURE_2D : GL_TEXTURE_2D_ARRAY), m_type(GL_UNSIGNED_BYTE), m_channel(info.format.first == GL_R8 ? 1 : 4)
+	  m_slot(info.slot), m_target(info.layer_count == 1 ? GL_TEXTURE_2D : GL_TEXTURE_2D_ARRAY), m_type(GL_UNSIGNED_BYTE), m_channel(info.format.first == GL_R8 ? 1 : 4), m_info(info)
 {
 	glGenTextures(1, &m_id);
 	bind(true);
@@ -50,25 +48,13 @@ Texture::Texture(const TextureCreateInfo& info)
 
 Texture::~Texture()
 {
-	if (current_binded_texture[m_slot] == m_id)
-		current_binded_texture[m_slot] = UINT32_MAX;
+	GLState::Instance().onDeleteTexture(m_id);
 	glDeleteTextures(1, &m_id);
 }
 
 void Texture::bind(bool force)
 {
-	if (!force && current_binded_texture[m_slot] == m_id)
-		return;
-
-	if (active_texture_slot != m_slot) {
-		glActiveTexture(GL_TEXTURE0 + m_slot);
-		active_texture_slot = m_slot;
-	}
-
-	if (current_binded_texture[m_slot] != m_id) {
-		glBindTexture(m_target, m_id);
-		current_binded_texture[m_slot] = m_id;
-	}
+	GLState::Instance().bindTexture(m_slot, m_target, m_id, force);
 }
 
 void Texture::bindImage(uint32_t unit)
@@ -45,6 +45,7 @@ class Texture {
 	GLenum m_format, m_target, m_type;
 	uint32_t m_width, m_height, m_channel, m_layer_count, m_slot;
 	uint32_t m_next_layer = 0;
+	TextureCreateInfo m_info;
 
 public:
 	Texture(const TextureCreateInfo& info);
@@ -59,8 +60,10 @@ public:
 
 	inline const GLuint getId() const { return m_id; };
 	inline const uint32_t getSlot() const { return m_slot; };
+	inline void setSlot(uint32_t slot) { m_slot = slot; }
 	inline const uint32_t getWidth() const { return m_width; }
 	inline const uint32_t getHeight() const { return m_height; }
+	inline const TextureCreateInfo& getInfo() const { return m_info; }
 };
 
 }
\ No newline at end of file
@@ -18,6 +18,7 @@
 
 #include "pch.h"
 #include "uniform_buffer.h"
+#include "gl_state.h"
 
 namespace d2gl {
 
@@ -34,17 +35,17 @@ UniformBuffer::UniformBuffer(const UniformBufferCreateInfo& info)
 
 	glGenBuffers(1, &m_id);
 
-	glBindBuffer(GL_UNIFORM_BUFFER, m_id);
+	GLState::Instance().bindBuffer(GL_UNIFORM_BUFFER, m_id);
 	glBufferData(GL_UNIFORM_BUFFER, m_size, NULL, GL_STATIC_DRAW);
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
 
 	m_binding = ubo_bindings;
-	glBindBufferRange(GL_UNIFORM_BUFFER, m_binding, m_id, 0, m_size);
+	GLState::Instance().bindBufferRange(GL_UNIFORM_BUFFER, m_binding, m_id, 0, m_size);
 	ubo_bindings++;
 }
 
 UniformBuffer::~UniformBuffer()
 {
+	GLState::Instance().onDeleteBuffer(m_id);
 	glDeleteBuffers(1, &m_id);
 }
 
@@ -73,12 +74,26 @@ void UniformBuffer::updateData(const std::string& name, const void* data)
 	if (!checkVariable(name))
 		return;
 
-	const uintptr_t offset = m_variable_data[name].offset;
-	const size_t size = m_variable_data[name].size;
+	const auto& variable = m_variable_data[name];
+	updateData(UboHandle{ variable.offset, variable.size }, data);
+}
+
+void UniformBuffer::updateData(UboHandle handle, const void* data)
+{
+	if (!handle.size)
+		return;
+
+	GLState::Instance().bindBuffer(GL_UNIFORM_BUFFER, m_id);
+	glBufferSubData(GL_UNIFORM_BUFFER, handle.offset, handle.size, data);
+}
+
+UboHandle UniformBuffer::getHandle(const std::string& name)
+{
+	if (!checkVariable(name))
+		return {};
 
-	glBindBuffer(GL_UNIFORM_BUFFER, m_id);
-	glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
-	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	const auto& variable = m_variable_data[name];
+	return { variable.offset, variable.size };
 }
 
 void UniformBuffer::updateHash(const std::string& name, uint32_t hash)
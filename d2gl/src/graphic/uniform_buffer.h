@@ -31,6 +31,11 @@ struct UboVariableData {
 	uint32_t hash = 0;
 };
 
+struct UboHandle {
+	uint32_t offset = 0;
+	uint32_t size = 0;
+};
+
 struct UniformBufferCreateInfo {
 	std::vector<UboVariable> variables;
 };
@@ -50,6 +55,8 @@ public:
 	void updateDataVec4f(const std::string& name, const glm::vec4& value);
 	void updateDataMat4f(const std::string& name, const glm::mat4& value);
 	void updateData(const std::string& name, const void* data);
+	void updateData(UboHandle handle, const void* data);
+	UboHandle getHandle(const std::string& name);
 	void updateHash(const std::string& name, uint32_t hash);
 	const uint32_t getHash(const std::string& name);
 
@@ -19,6 +19,8 @@
 #include "pch.h"
 #include "upscaler.h"
 #include "helpers.h"
+#include "image_decoder.h"
+#include "resource_pool.h"
 
 #include <glslang/glslang.h>
 
@@ -27,11 +29,10 @@ namespace d2gl {
 Upscaler::Upscaler()
 {
 	auto buffer = helpers::loadFile("shaders\\list.txt");
-	if (!buffer.size)
+	if (!buffer || !buffer->getSize())
 		return;
 
-	std::string preset_list((const char*)buffer.data, buffer.size);
-	delete[] buffer.data;
+	std::string preset_list = buffer->getString();
 
 	auto lines = helpers::strToLines(preset_list);
 	if (App.direct) {
@@ -53,29 +54,32 @@ Upscaler::Upscaler()
 	}
 
 	helpers::replaceAll(App.shader.preset, "/", "\\");
+	auto preset_index = loadPresetIndex();
+	bool index_changed = false;
+
+	std::unordered_map<std::string, PresetIndexEntry> new_index;
 	for (auto& line : lines) {
 		helpers::trimString(line, "\t\n\v\f\r ");
-		auto buf = helpers::loadFile("shaders\\" + line);
-		if (!buf.size)
-			return;
+		if (line.empty())
+			continue;
 
-		size_t pass_count = 1;
-		std::string preset_source((const char*)buf.data, buf.size);
-		delete[] buf.data;
+		auto entry = getPresetStamp(line);
+		auto it = preset_index.find(line);
+		if (it != preset_index.end() && it->second.time == entry.time && it->second.size == entry.size)
+			entry.pass_count = it->second.pass_count;
+		else {
+			auto buf = helpers::loadFile("shaders\\" + line);
+			if (!buf || !buf->getSize())
+				return;
 
-		auto pos = preset_source.find("shaders =");
-		if (pos == std::string::npos)
-			pos = preset_source.find("shaders=");
-		if (pos != std::string::npos) {
-			auto pos2 = preset_source.find("\n", pos);
-			auto count_str = preset_source.substr(pos, pos2 - pos);
-			helpers::trimString(count_str, "\t\n\v\f\r ");
-			count_str.erase(std::remove_if(count_str.begin(), count_str.end(), (int (*)(int))std::isspace), count_str.end());
-			count_str = count_str.substr(8);
-			count_str.erase(std::remove(count_str.begin(), count_str.end(), '"'), count_str.end());
-			pass_count = std::stoul(count_str);
+			std::string preset_source = buf->getString();
+
+			entry.pass_count = getPassCount(preset_source);
+			index_changed = true;
 		}
+		new_index[line] = entry;
 
+		const uint32_t pass_count = entry.pass_count;
 		std::string name = line + " (" + std::to_string(pass_count) + " Pass" + (pass_count > 1 ? "es" : "") + ")";
 		App.shader.presets.items.push_back({ name, line });
 		if (App.shader.preset == line) {
@@ -83,22 +87,36 @@ Upscaler::Upscaler()
 			App.shader.selected = App.shader.presets.selected;
 		}
 	}
+
+	if (index_changed || new_index.size() != preset_index.size())
+		savePresetIndex(new_index);
 }
 
 bool Upscaler::loadPreset()
 {
 	const auto preset_name = App.shader.presets.items[App.shader.presets.selected].value;
+	if (!loadPreset(preset_name))
+		return false;
+
+	App.shader.preset = preset_name;
+	return true;
+}
+
+bool Upscaler::loadPreset(const std::string& preset_name)
+{
 	std::string preset_path = "shaders\\" + preset_name;
 
 	auto buffer = helpers::loadFile(preset_path);
-	if (!buffer.size)
+	if (!buffer || !buffer->getSize())
 		return false;
 
-	std::string preset_source((const char*)buffer.data, buffer.size);
-	delete[] buffer.data;
+	std::string preset_source = buffer->getString();
 
+	for (auto& pass : m_passes)
+		ResourcePool::Instance().release(pass.frame_buffer);
 	m_passes.clear();
 	m_textures.clear();
+	std::vector<ShaderSource> shaders;
 	std::unordered_map<std::string, TextureInfo> texture_info;
 	std::unordered_map<std::string, float> preset_params;
 
@@ -125,6 +143,7 @@ bool Upscaler::loadPreset()
 			const size_t count = std::stoul(value);
 			for (size_t i = 0; i < count; i++)
 				m_passes.push_back({ "Pass #" + std::to_string(i + 1) });
+			shaders.resize(count);
 			continue;
 		}
 
@@ -141,11 +160,9 @@ bool Upscaler::loadPreset()
 			index = std::stoul(index_s);
 		bool pass_data = index < (int)m_passes.size();
 
-		if (var_name == "shader" && pass_data) {
-			auto shader_path = helpers::filePathFix(preset_path, value);
-			if (!prepareShader(m_passes[index], shader_path))
-				return false;
-		} else if (var_name == "alias" && pass_data)
+		if (var_name == "shader" && pass_data)
+			shaders[index].path = helpers::filePathFix(preset_path, value);
+		else if (var_name == "alias" && pass_data)
 			m_passes[index].name = value;
 		else if (var_name == "filter_linear" && pass_data)
 			m_passes[index].linear_filter = (value == "true" || value == "1");
@@ -207,6 +224,16 @@ bool Upscaler::loadPreset()
 		}
 	}
 
+	// Lookup textures decode on workers while the shaders compile.
+	ImageDecoder image_decoder;
+	for (auto& p : texture_info)
+		image_decoder.add(p.second.path, false);
+
+	const bool prepared = prepareShaders(shaders);
+	m_include_cache.clear();
+	if (!prepared)
+		return false;
+
 	for (auto& pass : m_passes) {
 		for (auto& pass_param : pass.params) {
 			if (preset_params.find(pass_param.id) != preset_params.end()) {
@@ -216,8 +243,9 @@ bool Upscaler::loadPreset()
 	}
 
 	size_t tex_slot = m_passes.size() + 1;
+	size_t image_index = 0;
 	for (auto& p : texture_info) {
-		auto image_data = helpers::loadImage(p.second.path, false);
+		auto image_data = image_decoder.get(image_index++);
 		if (image_data.data) {
 			TextureCreateInfo texture_ci;
 			texture_ci.size = { image_data.width, image_data.height };
@@ -233,13 +261,12 @@ bool Upscaler::loadPreset()
 		}
 	}
 
-	App.shader.preset = preset_name;
 	return true;
 }
 
 void Upscaler::loadDefaultPreset()
 {
-	const std::string defalut_preset = "bilinear.slangp";
+	const std::string defalut_preset = UPSCALER_DEFAULT_PRESET;
 	for (size_t i = 0; i < App.shader.presets.items.size(); i++) {
 		if (App.shader.presets.items[i].value == defalut_preset) {
 			App.shader.presets.selected = i;
@@ -263,9 +290,10 @@ void Upscaler::setupPasses()
 	texture_ci.slot = TEXTURE_SLOT_DEFAULT;
 	if (m_passes[0].linear_filter)
 		texture_ci.filter = { GL_LINEAR, GL_LINEAR };
-	m_input_texture = Context::createTexture(texture_ci);
+	ResourcePool::Instance().acquire(m_input_texture, texture_ci);
 
 	m_passes[0].out_size = App.game.tex_size;
+	m_dynamic_allowed = true;
 	glm::uvec2 vwp_size = { (uint32_t)((float)App.game.tex_size.x * App.viewport.scale.x), (uint32_t)((float)App.game.tex_size.y * App.viewport.scale.y) };
 
 	for (size_t i = 0; i < m_passes.size(); i++) {
@@ -286,12 +314,18 @@ void Upscaler::setupPasses()
 		} else
 			pass.out_size = vwp_size;
 
+		// Passes sized from the viewport, directly or through their source, can render at a fraction of it.
+		const bool dynamic_x = pass.scale_type.x == ScaleType::Viewport || (pass.scale_type.x == ScaleType::Source && i > 0 && prev.dynamic);
+		const bool dynamic_y = pass.scale_type.y == ScaleType::Viewport || (pass.scale_type.y == ScaleType::Source && i > 0 && prev.dynamic);
+		pass.dynamic = !is_last && (dynamic_x || dynamic_y);
+		pass.render_size = pass.out_size;
+
 		if (!is_last) {
 			GLint filter = next.linear_filter ? GL_LINEAR : GL_NEAREST;
 			FrameBufferCreateInfo frambuffer_ci;
 			frambuffer_ci.size = pass.out_size;
 			frambuffer_ci.attachments = { { i + 1, {}, { filter, filter }, pass.format } };
-			pass.frame_buffer = Context::createFrameBuffer(frambuffer_ci);
+			ResourcePool::Instance().acquire(pass.frame_buffer, frambuffer_ci);
 			if (!pass.frame_buffer->isComplete()) {
 				complete = false;
 				break;
@@ -316,13 +350,16 @@ void Upscaler::setupPasses()
 		}
 
 		if (auto u = pass.getUniformPrefixed("SourceSize"); u != "") {
+			pass.source_size_uniform = pass.pipeline->getUniformHandle(u);
 			if (i == 0)
 				pass.pipeline->setUniformVec4f(u, { (float)App.game.tex_size.x, (float)App.game.tex_size.y, 1.0f / (float)App.game.tex_size.x, 1.0f / (float)App.game.tex_size.y });
 			else
 				pass.pipeline->setUniformVec4f(u, { (float)prev.out_size.x, (float)prev.out_size.y, 1.0f / (float)prev.out_size.x, 1.0f / (float)prev.out_size.y });
 		}
-		if (auto u = pass.getUniformPrefixed("OutputSize"); u != "")
+		if (auto u = pass.getUniformPrefixed("OutputSize"); u != "") {
+			pass.output_size_uniform = pass.pipeline->getUniformHandle(u);
 			pass.pipeline->setUniformVec4f(u, { (float)pass.out_size.x, (float)pass.out_size.y, 1.0f / (float)pass.out_size.x, 1.0f / (float)pass.out_size.y });
+		}
 		if (auto u = pass.getUniformPrefixed("FinalViewportSize"); u != "")
 			pass.pipeline->setUniformVec4f(u, { (float)vwp_size.x, (float)vwp_size.y, 1.0f / (float)vwp_size.x, 1.0f / (float)vwp_size.y });
 
@@ -337,6 +374,7 @@ void Upscaler::setupPasses()
 				const glm::vec4 out_size = { (float)p_pass.out_size.x, (float)p_pass.out_size.y, 1.0f / (float)p_pass.out_size.x, 1.0f / (float)p_pass.out_size.y };
 				if (p_pass.name != "") {
 					if (auto u = pass.getSamplerName(p_pass.name); u != "") {
+						m_dynamic_allowed &= !p_pass.dynamic;
 						pass.pipeline->setUniform1i(u, j + 1);
 						bindings.push_back({ BindingType::FBTexture, u, j + 1, &p_pass.frame_buffer });
 					}
@@ -345,6 +383,7 @@ void Upscaler::setupPasses()
 				}
 				const std::string num = std::to_string(j);
 				if (auto u = pass.getSamplerName("PassOutput" + num); u != "") {
+					m_dynamic_allowed &= !p_pass.dynamic;
 					pass.pipeline->setUniform1i(u, j + 1);
 					bindings.push_back({ BindingType::FBTexture, u, j + 1, &p_pass.frame_buffer });
 				}
@@ -353,10 +392,8 @@ void Upscaler::setupPasses()
 			}
 		}
 
-		if (auto u = pass.getUniformPrefixed("FrameCount"); u != "") {
-			if (pass.pipeline->getUniformLocation(u) > -1)
-				pass.frame_count_uniform = u;
-		}
+		if (auto u = pass.getUniformPrefixed("FrameCount"); u != "")
+			pass.frame_count_uniform = pass.pipeline->getUniformHandle(u);
 
 		for (auto& p : m_textures) {
 			if (auto u = pass.getSamplerName(p.first); u != "") {
@@ -368,12 +405,59 @@ void Upscaler::setupPasses()
 			pass.pipeline->updateBindings(bindings);
 	}
 
+	m_render_scale = 1.0f;
+
 	if (!complete) {
 		loadDefaultPreset();
 		setupPasses();
 	}
 }
 
+void Upscaler::setRenderScale(float scale)
+{
+	if (!m_dynamic_allowed)
+		scale = 1.0f;
+
+	if (m_passes.empty() || scale == m_render_scale)
+		return;
+
+	m_render_scale = scale;
+	const glm::uvec2 vwp_size = m_passes.back().out_size;
+
+	for (size_t i = 0; i < m_passes.size(); i++) {
+		auto& pass = m_passes[i];
+		const auto& prev = m_passes[i - (i > 0 ? 1 : 0)];
+		const glm::uvec2 source_size = i == 0 ? App.game.tex_size : prev.render_size;
+
+		if (pass.dynamic) {
+			for (int j = 0; j < 2; j++) {
+				if (pass.scale_type[j] == ScaleType::Viewport)
+					pass.render_size[j] = (uint32_t)(vwp_size[j] * scale * pass.scale_size[j]);
+				else if (pass.scale_type[j] == ScaleType::Source)
+					pass.render_size[j] = (uint32_t)(source_size[j] * pass.scale_size[j]);
+				pass.render_size[j] = glm::clamp(pass.render_size[j], 1u, pass.out_size[j]);
+			}
+		}
+
+		// A scaled pass gets a frame buffer of its render size, so the passes reading it keep
+		// sampling the full [0, 1] range. The pool keeps the ones of recent scale steps around.
+		if (pass.dynamic && pass.frame_buffer->getInfo().size != pass.render_size) {
+			auto frame_buffer_ci = pass.frame_buffer->getInfo();
+			frame_buffer_ci.size = pass.render_size;
+			ResourcePool::Instance().acquire(pass.frame_buffer, frame_buffer_ci);
+		}
+
+		if (pass.source_size_uniform.location < 0 && (pass.output_size_uniform.location < 0 || !pass.dynamic))
+			continue;
+
+		pass.pipeline->bind();
+		if (pass.source_size_uniform.location > -1)
+			pass.pipeline->setUniformVec4f(pass.source_size_uniform, { (float)source_size.x, (float)source_size.y, 1.0f / (float)source_size.x, 1.0f / (float)source_size.y });
+		if (pass.output_size_uniform.location > -1 && pass.dynamic)
+			pass.pipeline->setUniformVec4f(pass.output_size_uniform, { (float)pass.render_size.x, (float)pass.render_size.y, 1.0f / (float)pass.render_size.x, 1.0f / (float)pass.render_size.y });
+	}
+}
+
 void Upscaler::process(const std::unique_ptr<FrameBuffer>& in_fbo, const glm::ivec2& vp_size, const glm::ivec2& vp_offset, const std::unique_ptr<FrameBuffer>& out_fbo)
 {
 	Context* ctx = App.context.get();
@@ -393,27 +477,54 @@ void Upscaler::process(const std::unique_ptr<FrameBuffer>& in_fbo, const glm::iv
 			}
 		} else {
 			ctx->bindFrameBuffer(pass.frame_buffer, false);
-			ctx->setViewport(pass.out_size);
+			ctx->setViewport(pass.render_size);
 		}
 		ctx->bindPipeline(pass.pipeline);
-		if (pass.frame_count_uniform != "")
+		if (pass.frame_count_uniform.location > -1)
 			pass.pipeline->setUniform1u(pass.frame_count_uniform, ctx->getFrameCount());
 		ctx->drawQuad();
 	}
 }
 
-bool Upscaler::prepareShader(ShaderPass& pass, std::string shader_path)
+bool Upscaler::prepareShaders(std::vector<ShaderSource>& shaders)
 {
-	auto buffer = helpers::loadFile(shader_path);
-	if (!buffer.size)
+	for (size_t i = 0; i < m_passes.size(); i++) {
+		if (!shaders[i].path.empty() && !parseShader(m_passes[i], shaders[i]))
+			return false;
+	}
+
+	// The glslang wrapper is a prebuilt library that is not known to be reentrant, passes are
+	// cross-compiled one at a time. Cached passes skip glslang entirely.
+	for (auto& shader : shaders) {
+		if (!shader.path.empty())
+			compileShader(shader);
+	}
+
+	for (size_t i = 0; i < m_passes.size(); i++) {
+		if (shaders[i].path.empty())
+			continue;
+
+		if (!shaders[i].error.empty()) {
+			error_log("%s", shaders[i].error.c_str());
+			return false;
+		}
+		if (!createShader(m_passes[i], shaders[i].entry))
+			return false;
+	}
+
+	return true;
+}
+
+bool Upscaler::parseShader(ShaderPass& pass, ShaderSource& shader)
+{
+	auto buffer = helpers::loadFile(shader.path);
+	if (!buffer || !buffer->getSize())
 		return false;
 
-	std::string shader_source((const char*)buffer.data, buffer.size);
-	delete[] buffer.data;
-	resolveInclude(shader_source, shader_path);
+	std::string shader_source = buffer->getString();
+	resolveInclude(shader_source, shader.path);
 
 	uint8_t stage = 0;
-	std::string vert_source, frag_source;
 
 	auto lines = helpers::strToLines(shader_source);
 	for (auto& line : lines) {
@@ -425,7 +536,8 @@ bool Upscaler::prepareShader(ShaderPass& pass, std::string shader_path)
 			if (pragma_name == "stage")
 				stage = pragma_value == "vertex" ? 1 : 2;
 			else if (pragma_name == "name") {
-				pass.name = pragma_value;
+				if (pass.name.empty())
+					pass.name = pragma_value;
 				pass.label += " (" + pragma_value + ")";
 			} else if (pragma_name == "format")
 				pass.format = getFramebufferFormat(pragma_value);
@@ -450,109 +562,212 @@ bool Upscaler::prepareShader(ShaderPass& pass, std::string shader_path)
 			continue;
 		}
 		if (stage == 0 || stage == 1)
-			vert_source += line + "\n";
+			shader.vert_source += line + "\n";
 		if (stage == 0 || stage == 2)
-			frag_source += line + "\n";
+			shader.frag_source += line + "\n";
 	}
+	shader.name = pass.name;
+
+	return true;
+}
+
+void Upscaler::compileShader(ShaderSource& shader)
+{
+	const auto cache_key = ShaderCache::getKey(shader.vert_source, shader.frag_source);
+	if (ShaderCache::load(cache_key, shader.entry))
+		return;
 
 	glslang::Result res1, res2;
 	try {
-		res1 = glslang::getGLSLCode(glslang::ShaderStage::Vertex, { App.gl_ver.x, App.gl_ver.y }, vert_source);
+		res1 = glslang::getGLSLCode(glslang::ShaderStage::Vertex, { App.gl_ver.x, App.gl_ver.y }, shader.vert_source);
 		if (!res1.result) {
-			error_log("Vertex shader compile failed! %s: %s", pass.name.c_str(), res1.err_msg.c_str());
-			return false;
+			shader.error = "Vertex shader compile failed! " + shader.name + ": " + res1.err_msg;
+			return;
 		}
-		res2 = glslang::getGLSLCode(glslang::ShaderStage::Fragment, { App.gl_ver.x, App.gl_ver.y }, frag_source);
+		res2 = glslang::getGLSLCode(glslang::ShaderStage::Fragment, { App.gl_ver.x, App.gl_ver.y }, shader.frag_source);
 		if (!res2.result) {
-			error_log("Fragment shader compile failed! %s: %s", pass.name.c_str(), res2.err_msg.c_str());
-			return false;
+			shader.error = "Fragment shader compile failed! " + shader.name + ": " + res2.err_msg;
+			return;
 		}
 	} catch (...) {
-		error_log("Slang to GLSL shader compile failed! %s", pass.name.c_str());
-		return false;
+		shader.error = "Slang to GLSL shader compile failed! " + shader.name;
+		return;
 	}
+
 	res1.source = res1.source.erase(0, res1.source.find("\n") + 1);
 	res2.source = res2.source.erase(0, res2.source.find("\n") + 1);
-	std::string source = "#ifdef VERTEX\n" + res1.source + "\n#elif FRAGMENT\n" + res2.source + "\n#endif";
+	shader.entry.source = "#ifdef VERTEX\n" + res1.source + "\n#elif FRAGMENT\n" + res2.source + "\n#endif";
+
+	shader.entry.samplers = res1.samplers;
+	shader.entry.samplers.insert(shader.entry.samplers.end(), res2.samplers.begin(), res2.samplers.end());
 
+	shader.entry.uniforms = res1.uniforms;
+	for (const auto& p : res2.uniforms)
+		shader.entry.uniforms[p.first] = p.second;
+
+	ShaderCache::save(cache_key, shader.entry);
+}
+
+bool Upscaler::createShader(ShaderPass& pass, const ShaderCacheEntry& entry)
+{
 	PipelineCreateInfo pipeline_ci = { pass.name };
-	pipeline_ci.shader = source.c_str();
+	pipeline_ci.shader = entry.source.c_str();
 	pipeline_ci.version = App.gl_ver;
 	pass.pipeline = Context::createPipeline(pipeline_ci);
 	if (!pass.pipeline->isCompileSuccess())
 		return false;
 
-	for (const auto& p : res1.samplers)
-		pass.samplers.push_back(p);
-	for (const auto& p : res2.samplers)
+	for (const auto& p : entry.samplers)
 		pass.samplers.push_back(p);
 
-	for (const auto& p : res1.uniforms)
-		pass.uniforms[p.first] = p.second;
-	for (const auto& p : res2.uniforms)
+	for (const auto& p : entry.uniforms)
 		pass.uniforms[p.first] = p.second;
 
 	return true;
 }
 
-void Upscaler::resolveInclude(std::string& source, std::string file_path)
+std::unordered_map<std::string, PresetIndexEntry> Upscaler::loadPresetIndex()
 {
-	bool dqm = false;
-	int s1 = -1, s2 = -1;
-	std::deque<std::pair<size_t, size_t>> cm_occurrences;
+	std::unordered_map<std::string, PresetIndexEntry> preset_index;
 
-	for (size_t i = 0; i < source.size() - 1; i++) {
-		const auto c0 = source[i];
-		const auto c1 = source[i + 1];
-		const bool end = i + 2 == source.size();
-		if (!dqm) {
-			if (s1 > -1 && (end || (c0 == '*' && c1 == '/'))) {
-				i++;
-				cm_occurrences.push_front({ s1, i + 1 - s1 });
-				s1 = -1;
-			} else if (s2 > -1 && (end || c0 == '\n' || c0 == '\r')) {
-				cm_occurrences.push_front({ s2, i + 1 - s2 });
-				s2 = -1;
-			} else if (s1 == -1 && s2 == -1 && c0 == '/') {
-				if (c1 == '*')
-					s1 = i;
-				else if (c1 == '/')
-					s2 = i;
-			}
+	std::ifstream file(App.cache_dir + "presets.idx");
+	std::string line;
+	if (!file.is_open() || !std::getline(file, line) || line != PRESET_INDEX_HEADER)
+		return preset_index;
+
+	while (std::getline(file, line)) {
+		const auto seg = helpers::splitToVector(line, '\t');
+		if (seg.size() != 4)
+			continue;
+
+		try {
+			preset_index[seg[3]] = { (uint32_t)std::stoul(seg[0]), std::stoull(seg[1]), std::stoull(seg[2]) };
+		} catch (...) {
+			continue;
 		}
-		if (s1 == -1 && s2 == -1 && c0 == '"')
-			dqm = !dqm;
 	}
 
-	for (auto& p : cm_occurrences)
-		source.erase(p.first, p.second);
+	return preset_index;
+}
+
+void Upscaler::savePresetIndex(const std::unordered_map<std::string, PresetIndexEntry>& preset_index)
+{
+	std::error_code ec;
+	std::filesystem::create_directories(App.cache_dir, ec);
 
-	size_t start = 0;
-	std::deque<std::tuple<size_t, size_t, std::string>> inc_occurrences;
+	std::ofstream file(App.cache_dir + "presets.idx", std::ios::trunc);
+	if (!file.is_open())
+		return;
 
-	while ((start = source.find("#include", start)) != std::string::npos) {
-		size_t s_pos = start + 9;
-		size_t e_pos = source.find("\n", s_pos);
-		e_pos = e_pos == std::string::npos ? source.length() : e_pos;
-		std::string inc_file = source.substr(s_pos, e_pos - s_pos);
+	file << PRESET_INDEX_HEADER << "\n";
+	for (auto& p : preset_index)
+		file << p.second.pass_count << "\t" << p.second.time << "\t" << p.second.size << "\t" << p.first << "\n";
+}
+
+PresetIndexEntry Upscaler::getPresetStamp(const std::string& preset)
+{
+	static PresetIndexEntry mpq_stamp = { 0, 0, 0 };
+	static bool mpq_checked = false;
 
-		helpers::trimString(inc_file, "\t\n\v\f\r ");
-		inc_file.erase(std::remove(inc_file.begin(), inc_file.end(), '"'), inc_file.end());
-		inc_occurrences.push_front({ start, e_pos - start, inc_file });
-		start += 9;
+	auto getStamp = [](const std::string& path, PresetIndexEntry& entry) {
+		std::error_code ec;
+		const auto time = std::filesystem::last_write_time(path, ec);
+		if (ec)
+			return false;
+
+		entry.time = (uint64_t)time.time_since_epoch().count();
+		entry.size = (uint64_t)std::filesystem::file_size(path, ec);
+		return !ec;
+	};
+
+	PresetIndexEntry entry = { 0, 0, 0 };
+	if (App.direct && getStamp(helpers::getCurrentDir() + "data\\shaders\\" + preset, entry))
+		return entry;
+
+	if (!mpq_checked) {
+		getStamp(helpers::getCurrentDir() + App.mpq_file, mpq_stamp);
+		mpq_checked = true;
 	}
 
-	for (auto& p : inc_occurrences) {
-		auto inc_file = helpers::filePathFix(file_path, std::get<2>(p));
-		std::string inc_file_source = "";
-		auto buffer = helpers::loadFile(inc_file);
-		if (buffer.size) {
-			inc_file_source = std::string((const char*)buffer.data, buffer.size);
-			delete[] buffer.data;
-			resolveInclude(inc_file_source, inc_file);
-			source.replace(std::get<0>(p), std::get<1>(p), inc_file_source);
+	return mpq_stamp;
+}
+
+uint32_t Upscaler::getPassCount(const std::string& preset_source)
+{
+	auto pos = preset_source.find("shaders =");
+	if (pos == std::string::npos)
+		pos = preset_source.find("shaders=");
+	if (pos == std::string::npos)
+		return 1;
+
+	auto pos2 = preset_source.find("\n", pos);
+	auto count_str = preset_source.substr(pos, pos2 - pos);
+	helpers::trimString(count_str, "\t\n\v\f\r ");
+	count_str.erase(std::remove_if(count_str.begin(), count_str.end(), (int (*)(int))std::isspace), count_str.end());
+	count_str = count_str.substr(8);
+	count_str.erase(std::remove(count_str.begin(), count_str.end(), '"'), count_str.end());
+
+	return std::stoul(count_str);
+}
+
+void Upscaler::resolveInclude(std::string& source, const std::string& file_path)
+{
+	const size_t size = source.size();
+	bool dqm = false;
+
+	std::string output;
+	output.reserve(size);
+
+	for (size_t i = 0; i < size; i++) {
+		const auto c0 = source[i];
+		const auto c1 = i + 1 < size ? source[i + 1] : '\0';
+
+		if (!dqm && c0 == '/' && c1 == '*') {
+			const size_t e_pos = source.find("*/", i + 2);
+			i = (e_pos == std::string::npos ? size : e_pos + 2) - 1;
+			continue;
+		}
+		if (!dqm && c0 == '/' && c1 == '/') {
+			const size_t e_pos = source.find_first_of("\r\n", i + 2);
+			i = (e_pos == std::string::npos ? size : e_pos) - 1;
+			continue;
 		}
+
+		if (!dqm && c0 == '#' && source.compare(i, 8, "#include") == 0) {
+			size_t e_pos = source.find('\n', i);
+			e_pos = e_pos == std::string::npos ? size : e_pos;
+
+			std::string inc_file = source.substr(i + 8, e_pos - i - 8);
+			inc_file = inc_file.substr(0, std::min(inc_file.find("//"), inc_file.find("/*")));
+			helpers::trimString(inc_file, "\t\n\v\f\r ");
+			inc_file.erase(std::remove(inc_file.begin(), inc_file.end(), '"'), inc_file.end());
+
+			const auto inc_path = helpers::filePathFix(file_path, inc_file);
+			auto it = m_include_cache.find(inc_path);
+			if (it == m_include_cache.end()) {
+				auto buffer = helpers::loadFile(inc_path);
+				if (buffer && buffer->getSize()) {
+					std::string inc_source = buffer->getString();
+					resolveInclude(inc_source, inc_path);
+					it = m_include_cache.insert({ inc_path, std::move(inc_source) }).first;
+				}
+			}
+
+			if (it != m_include_cache.end())
+				output += it->second;
+			else
+				output.append(source, i, e_pos - i);
+
+			i = e_pos - 1;
+			continue;
+		}
+
+		if (c0 == '"')
+			dqm = !dqm;
+		output.push_back(c0);
 	}
+
+	source.swap(output);
 }
 
 std::pair<GLint, GLenum> Upscaler::getFramebufferFormat(const std::string& format)
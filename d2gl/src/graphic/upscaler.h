@@ -19,6 +19,10 @@
 #pragma once
 
 #include "pipeline.h"
+#include "shader_cache.h"
+
+#define PRESET_INDEX_HEADER "D2GL preset index v1"
+#define UPSCALER_DEFAULT_PRESET "bilinear.slangp"
 
 namespace d2gl {
 
@@ -48,10 +52,14 @@ struct ShaderPass {
 	std::string label;
 	std::string name = "";
 	glm::vec<2, uint32_t> out_size = { 0, 0 };
+	glm::vec<2, uint32_t> render_size = { 0, 0 };
+	bool dynamic = false;
 	glm::vec<2, ScaleType> scale_type = { ScaleType::Source, ScaleType::Source };
 	glm::vec2 scale_size = { 1.0f, 1.0f };
 	bool linear_filter = false;
-	std::string frame_count_uniform = "";
+	UniformHandle frame_count_uniform;
+	UniformHandle source_size_uniform;
+	UniformHandle output_size_uniform;
 
 	std::vector<ShaderParam> params;
 	std::unique_ptr<Pipeline> pipeline;
@@ -64,10 +72,28 @@ struct ShaderPass {
 	inline std::string getUniformPrefixed(const std::string& uniform) const { return uniforms.find(uniform) != uniforms.end() ? uniforms.at(uniform) + "." + uniform : ""; }
 };
 
+struct PresetIndexEntry {
+	uint32_t pass_count;
+	uint64_t time;
+	uint64_t size;
+};
+
+struct ShaderSource {
+	std::string path;
+	std::string name;
+	std::string vert_source;
+	std::string frag_source;
+	std::string error;
+	ShaderCacheEntry entry;
+};
+
 class Upscaler {
 	std::vector<ShaderPass> m_passes = {};
 	std::unique_ptr<Texture> m_input_texture;
 	std::unordered_map<std::string, std::unique_ptr<Texture>> m_textures;
+	std::unordered_map<std::string, std::string> m_include_cache;
+	float m_render_scale = 1.0f;
+	bool m_dynamic_allowed = false;
 
 	Upscaler();
 	~Upscaler() = default;
@@ -80,14 +106,26 @@ public:
 	}
 
 	bool loadPreset();
+	bool loadPreset(const std::string& preset_name);
 	void loadDefaultPreset();
 	void setupPasses();
+	void setRenderScale(float scale);
+	inline float getRenderScale() const { return m_render_scale; }
 	void process(const std::unique_ptr<FrameBuffer>& in_fbo, const glm::ivec2& vp_size, const glm::ivec2& vp_offset, const std::unique_ptr<FrameBuffer>& out_fbo = nullptr);
 
 private:
-	bool prepareShader(ShaderPass& pass, std::string shader_path);
+	bool prepareShaders(std::vector<ShaderSource>& shaders);
+	bool parseShader(ShaderPass& pass, ShaderSource& shader);
+	bool createShader(ShaderPass& pass, const ShaderCacheEntry& entry);
+	void resolveInclude(std::string& source, const std::string& file_path);
+
+	static void compileShader(ShaderSource& shader);
+
+	static std::unordered_map<std::string, PresetIndexEntry> loadPresetIndex();
+	static void savePresetIndex(const std::unordered_map<std::string, PresetIndexEntry>& preset_index);
+	static PresetIndexEntry getPresetStamp(const std::string& preset);
+	static uint32_t getPassCount(const std::string& preset_source);
 
-	static void resolveInclude(std::string& source, std::string file_path);
 	static std::pair<GLint, GLenum> getFramebufferFormat(const std::string& format);
 };
 
@@ -46,25 +46,30 @@ struct Vertex {
 	}
 };
 
-struct VertexMod {
-	glm::vec<2, int16_t> position;
-	glm::vec2 tex_coord;
+struct InstanceMod {
+	glm::vec2 position;
+	glm::vec2 size;
+	glm::vec4 tex_coord;
 	uint32_t color1;
 	uint32_t color2;
 	glm::vec<2, uint16_t> tex_ids;
 	glm::vec<4, uint8_t> flags;
-	glm::vec<2, int16_t> extra;
+	glm::vec<4, int16_t> extra;
 
 	static void bindingDescription()
 	{
-		glEnableVertexAttribArray(6);
-		glVertexAttribPointer(0, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(VertexMod), (const void*)offsetof(VertexMod, position));
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(VertexMod), (const void*)offsetof(VertexMod, tex_coord));
-		glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(VertexMod), (const void*)offsetof(VertexMod, color1));
-		glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(VertexMod), (const void*)offsetof(VertexMod, color2));
-		glVertexAttribIPointer(4, 2, GL_UNSIGNED_SHORT, sizeof(VertexMod), (const void*)offsetof(VertexMod, tex_ids));
-		glVertexAttribIPointer(5, 4, GL_UNSIGNED_BYTE, sizeof(VertexMod), (const void*)offsetof(VertexMod, flags));
-		glVertexAttribPointer(6, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(VertexMod), (const void*)offsetof(VertexMod, extra));
+		for (uint32_t i = 0; i <= 7; i++) {
+			glEnableVertexAttribArray(i);
+			glVertexAttribDivisor(i, 1);
+		}
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(InstanceMod), (const void*)offsetof(InstanceMod, position));
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(InstanceMod), (const void*)offsetof(InstanceMod, size));
+		glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceMod), (const void*)offsetof(InstanceMod, tex_coord));
+		glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(InstanceMod), (const void*)offsetof(InstanceMod, color1));
+		glVertexAttribPointer(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(InstanceMod), (const void*)offsetof(InstanceMod, color2));
+		glVertexAttribIPointer(5, 2, GL_UNSIGNED_SHORT, sizeof(InstanceMod), (const void*)offsetof(InstanceMod, tex_ids));
+		glVertexAttribIPointer(6, 4, GL_UNSIGNED_BYTE, sizeof(InstanceMod), (const void*)offsetof(InstanceMod, flags));
+		glVertexAttribPointer(7, 4, GL_HALF_FLOAT, GL_FALSE, sizeof(InstanceMod), (const void*)offsetof(InstanceMod, extra));
 	}
 };
 
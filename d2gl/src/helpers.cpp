@@ -359,52 +359,19 @@ uint32_t hash(const void* key, size_t len)
 	return h1;
 }
 
-BufferData loadFile(const std::string& file_path)
+AssetRef loadFile(const std::string& file_path, bool log_missing)
 {
-	static bool is_mpq_loaded = false;
-	if (!is_mpq_loaded) {
-		std::string mpq_path = getCurrentDir() + App.mpq_file;
-		if (!d2::mpqLoad(mpq_path.c_str()))
-			error_log("%s not loaded.", mpq_path.c_str());
-		is_mpq_loaded = true;
-	}
-
-	std::string path = std::string("data\\").append(file_path);
-
-	void* ref_file;
-	char c_filepath[MAX_PATH];
-	strncpy_s(c_filepath, path.c_str(), path.size());
-
-	if (d2::mpqOpenFile && d2::mpqOpenFile(c_filepath, &ref_file)) {
-		size_t return_size = 0;
-		DWORD fileSize = d2::mpqGetFileSize(ref_file, NULL);
-		uint8_t* cache = new uint8_t[fileSize + 1];
-
-		if (d2::mpqReadFile(ref_file, cache, fileSize, &return_size, NULL, NULL, NULL)) {
-			d2::mpqCloseFile(ref_file);
-
-			cache[fileSize] = 0;
-			return { return_size, cache };
-		} else
-			error_log("File (MPQ): \"%s\" read error.", path.c_str());
-
-		delete[] cache;
-		return { 0 };
-	} else
-		error_log("File (MPQ): \"%s\" could not opened!", path.c_str());
-
-	return { 0 };
+	return AssetCache::Instance().get(file_path, log_missing);
 }
 
 ImageData loadImage(const std::string& file_path, bool flipped)
 {
 	ImageData image = { 0 };
 
-	auto buffer = loadFile(file_path);
-	if (buffer.size) {
-		stbi_set_flip_vertically_on_load(flipped);
-		image.data = stbi_load_from_memory(buffer.data, buffer.size, &image.width, &image.height, &image.bit, 4);
-		delete[] buffer.data;
+	auto asset = loadFile(file_path);
+	if (asset && asset->getSize()) {
+		stbi_set_flip_vertically_on_load_thread(flipped);
+		image.data = stbi_load_from_memory(asset->getData(), (int)asset->getSize(), &image.width, &image.height, &image.bit, 4);
 	}
 
 	return image;
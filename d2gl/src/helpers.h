@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include "asset_cache.h"
+
 // clang-format off
 #define EXE_GAME     "game.exe"
 #define DLL_FOG      "fog.dll"
@@ -68,7 +70,7 @@ uintptr_t getProcOffset(LPCSTR module, LPCSTR function);
 
 uint32_t hash(const void* key, size_t len);
 
-BufferData loadFile(const std::string& file_path);
+AssetRef loadFile(const std::string& file_path, bool log_missing = true);
 ImageData loadImage(const std::string& file_path, bool flipped = true);
 void clearImage(ImageData& image);
 std::string saveScreenShot(uint8_t* data, int width, int height);
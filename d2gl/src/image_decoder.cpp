@@ -0,0 +1,103 @@
+/*
+	D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+	Copyright (C) 2023  Bayaraa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "image_decoder.h"
+#include "helpers.h"
+
+namespace d2gl {
+
+ImageDecoder::~ImageDecoder()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_job_condition.notify_all();
+
+	for (auto& thread : m_threads)
+		thread.join();
+
+	for (auto& job : m_jobs) {
+		if (job.state == ImageJobState::Ready)
+			helpers::clearImage(job.image);
+	}
+}
+
+size_t ImageDecoder::add(const std::string& file_path, bool flipped)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_jobs.push_back({ file_path, flipped });
+
+	// The thread calling get() decodes as well, so one core is left for it.
+	const size_t max_threads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+	if (m_threads.size() < max_threads && m_threads.size() < m_jobs.size() - m_next_job)
+		m_threads.emplace_back(&ImageDecoder::worker, this);
+
+	m_job_condition.notify_one();
+
+	return m_jobs.size() - 1;
+}
+
+ImageData ImageDecoder::get(size_t index)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (index >= m_jobs.size())
+		return { 0 };
+
+	auto& job = m_jobs[index];
+	if (job.state == ImageJobState::Pending) {
+		job.state = ImageJobState::Decoding;
+		lock.unlock();
+		job.image = helpers::loadImage(job.file_path, job.flipped);
+		lock.lock();
+	} else
+		m_ready_condition.wait(lock, [&job]() { return job.state != ImageJobState::Decoding; });
+
+	if (job.state == ImageJobState::Taken)
+		return { 0 };
+
+	job.state = ImageJobState::Taken;
+	return job.image;
+}
+
+void ImageDecoder::worker()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (!m_stop) {
+		while (m_next_job < m_jobs.size() && m_jobs[m_next_job].state != ImageJobState::Pending)
+			m_next_job++;
+
+		if (m_next_job == m_jobs.size()) {
+			m_job_condition.wait(lock);
+			continue;
+		}
+
+		auto& job = m_jobs[m_next_job++];
+		job.state = ImageJobState::Decoding;
+		lock.unlock();
+		auto image = helpers::loadImage(job.file_path, job.flipped);
+		lock.lock();
+
+		job.image = image;
+		job.state = ImageJobState::Ready;
+		m_ready_condition.notify_all();
+	}
+}
+
+}
@@ -0,0 +1,64 @@
+/*
+	D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+	Copyright (C) 2023  Bayaraa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+namespace d2gl {
+
+enum class ImageJobState {
+	Pending,
+	Decoding,
+	Ready,
+	Taken,
+};
+
+struct ImageJob {
+	std::string file_path;
+	bool flipped = true;
+	ImageData image = { 0 };
+	ImageJobState state = ImageJobState::Pending;
+};
+
+// Decodes images on worker threads while the GL thread uploads them. Results are taken
+// by index, so texture array layers keep the order the images were added in.
+class ImageDecoder {
+	std::deque<ImageJob> m_jobs;
+	size_t m_next_job = 0;
+	std::vector<std::thread> m_threads;
+	bool m_stop = false;
+	std::mutex m_mutex;
+	std::condition_variable m_job_condition;
+	std::condition_variable m_ready_condition;
+
+public:
+	ImageDecoder() = default;
+	~ImageDecoder();
+
+	size_t add(const std::string& file_path, bool flipped = true);
+
+	// Waits for the image, or decodes it on the calling thread if no worker picked it up yet.
+	// The caller owns the returned data (helpers::clearImage).
+	ImageData get(size_t index);
+
+	inline size_t getCount() const { return m_jobs.size(); }
+
+private:
+	void worker();
+};
+
+}
@@ -18,9 +18,42 @@
 
 #include "pch.h"
 
+#define LOG_RING_SIZE 1024
+#define LOG_MESSAGE_SIZE 512
+#define LOG_FLUSH_INTERVAL 100
+
 namespace d2gl {
 
+struct LogEntry {
+	std::atomic<uint32_t> sequence = 0;
+	uint8_t type = 0;
+	SYSTEMTIME time = {};
+	char message[LOG_MESSAGE_SIZE] = { 0 };
+};
+
+struct LogRepeat {
+	uint8_t type = 0;
+	SYSTEMTIME time = {};
+	uint32_t count = 0;
+	char message[LOG_MESSAGE_SIZE] = { 0 };
+};
+
 FILE* log_file = nullptr;
+LogEntry* log_entries = nullptr;
+std::atomic<uint32_t> log_enqueue_pos = 0;
+std::atomic<uint32_t> log_dequeue_pos = 0;
+std::atomic<uint32_t> log_dropped = 0;
+LogRepeat log_repeat;
+std::mutex log_mutex;
+HANDLE log_event = nullptr;
+LPTOP_LEVEL_EXCEPTION_FILTER log_prev_filter = nullptr;
+
+void logThread();
+void logDrain();
+bool logPush(uint8_t type, const SYSTEMTIME& time, const char* message);
+void logWrite(uint8_t type, const SYSTEMTIME& time, const char* message);
+void logWriteRepeat();
+LONG WINAPI logExceptionFilter(EXCEPTION_POINTERS* info);
 
 void logInit()
 {
@@ -29,13 +62,28 @@ void logInit()
 	freopen_s((FILE**)stdout, "CONOUT$", "w", stdout);
 #endif
 
-	if (App.log && logFileOpen("w") && log_file) {
-		time_t now = time(0);
-		tm gmt_time;
-		localtime_s(&gmt_time, &now);
-		fprintf(log_file, "== D2GL v%s logging started. (%d/%d/%d) ==\n\n", App.version_str.c_str(), gmt_time.tm_year + 1900, gmt_time.tm_mon + 1, gmt_time.tm_mday);
-		logFileClose();
-	}
+	if (!App.log || log_file)
+		return;
+
+	log_file = _fsopen(App.log_file.c_str(), "w", _SH_DENYWR);
+	if (!log_file)
+		return;
+
+	SYSTEMTIME time;
+	GetLocalTime(&time);
+	fprintf(log_file, "== D2GL v%s logging started. (%d/%d/%d) ==\n\n", App.version_str.c_str(), time.wYear, time.wMonth, time.wDay);
+	fflush(log_file);
+
+	// Never freed, the writer thread and the exit/crash flush may still use it at process exit.
+	log_entries = new LogEntry[LOG_RING_SIZE];
+	for (uint32_t i = 0; i < LOG_RING_SIZE; i++)
+		log_entries[i].sequence.store(i, std::memory_order_relaxed);
+
+	log_event = CreateEventA(NULL, FALSE, FALSE, NULL);
+	std::thread(logThread).detach();
+
+	atexit(logFlush);
+	log_prev_filter = SetUnhandledExceptionFilter(logExceptionFilter);
 }
 
 void logTrace(WORD color, bool newline, const char* format, ...)
@@ -71,32 +119,161 @@ void logTraceDef(uint8_t type, const char* format, ...)
 	printf("\n");
 }
 
-bool logFileOpen(const char* mode)
+void logFileWrite(uint8_t type, const char* format, ...)
 {
-	return fopen_s(&log_file, App.log_file.c_str(), mode) == 0;
+	if (!App.log || !log_entries)
+		return;
+
+	SYSTEMTIME time;
+	GetLocalTime(&time);
+
+	char message[LOG_MESSAGE_SIZE];
+	va_list args;
+	va_start(args, format);
+	const int length = vsnprintf(message, sizeof(message), format, args);
+	va_end(args);
+
+	if (length < 0)
+		return;
+
+	if (length < LOG_MESSAGE_SIZE && logPush(type, time, message)) {
+		if (type == 1)
+			SetEvent(log_event);
+		return;
+	}
+
+	// Full ring drops info lines, warnings, errors and long messages (shader logs) are written in place.
+	if (length < LOG_MESSAGE_SIZE && type == 0) {
+		log_dropped++;
+		return;
+	}
+
+	std::string long_message(length + 1, '\0');
+	va_start(args, format);
+	vsnprintf(long_message.data(), long_message.size(), format, args);
+	va_end(args);
+
+	std::lock_guard<std::mutex> lock(log_mutex);
+	logDrain();
+	logWrite(type, time, long_message.c_str());
+	fflush(log_file);
 }
 
-void logFileWrite(uint8_t type, const char* format, ...)
+void logFlush()
+{
+	if (!log_entries)
+		return;
+
+	// At exit the writer thread may have been terminated while holding the lock, do not wait on it for long.
+	bool locked = false;
+	for (uint32_t i = 0; i < 50 && !(locked = log_mutex.try_lock()); i++)
+		Sleep(2);
+
+	logDrain();
+	logWriteRepeat();
+	fflush(log_file);
+
+	if (locked)
+		log_mutex.unlock();
+}
+
+void logThread()
+{
+	while (true) {
+		WaitForSingleObject(log_event, LOG_FLUSH_INTERVAL);
+
+		std::lock_guard<std::mutex> lock(log_mutex);
+		logDrain();
+	}
+}
+
+bool logPush(uint8_t type, const SYSTEMTIME& time, const char* message)
+{
+	uint32_t pos = log_enqueue_pos.load(std::memory_order_relaxed);
+	LogEntry* entry;
+
+	while (true) {
+		entry = &log_entries[pos & (LOG_RING_SIZE - 1)];
+		const int32_t diff = (int32_t)(entry->sequence.load(std::memory_order_acquire) - pos);
+		if (diff == 0) {
+			if (log_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				break;
+		} else if (diff < 0)
+			return false;
+		else
+			pos = log_enqueue_pos.load(std::memory_order_relaxed);
+	}
+
+	entry->type = type;
+	entry->time = time;
+	strcpy_s(entry->message, message);
+	entry->sequence.store(pos + 1, std::memory_order_release);
+
+	if (pos - log_dequeue_pos.load(std::memory_order_relaxed) > LOG_RING_SIZE / 2)
+		SetEvent(log_event);
+
+	return true;
+}
+
+void logDrain()
 {
-	if (App.log && logFileOpen("a") && log_file) {
-		time_t now = time(0);
-		tm gmt_time;
-		localtime_s(&gmt_time, &now);
-		fprintf(log_file, "[%.2d:%.2d:%.2d][%s] ", gmt_time.tm_hour, gmt_time.tm_min, gmt_time.tm_sec, (type == 0 ? "INFO" : (type == 1 ? "ERROR" : "WARNING")));
-
-		va_list args;
-		va_start(args, format);
-		vfprintf(log_file, format, args);
-		va_end(args);
-		fprintf(log_file, "\n");
-		logFileClose();
+	bool written = false;
+	uint32_t pos = log_dequeue_pos.load(std::memory_order_relaxed);
+	while (true) {
+		auto entry = &log_entries[pos & (LOG_RING_SIZE - 1)];
+		if (entry->sequence.load(std::memory_order_acquire) != pos + 1)
+			break;
+
+		logWrite(entry->type, entry->time, entry->message);
+		entry->sequence.store(pos + LOG_RING_SIZE, std::memory_order_release);
+		log_dequeue_pos.store(++pos, std::memory_order_relaxed);
+		written = true;
+	}
+
+	if (const uint32_t dropped = log_dropped.exchange(0)) {
+		SYSTEMTIME time;
+		GetLocalTime(&time);
+		char message[64];
+		sprintf_s(message, "%u log messages dropped.", dropped);
+		logWrite(2, time, message);
+		written = true;
 	}
+
+	if (written)
+		fflush(log_file);
 }
 
-void logFileClose()
+void logWrite(uint8_t type, const SYSTEMTIME& time, const char* message)
 {
-	fclose(log_file);
-	log_file = nullptr;
+	if (log_repeat.type == type && !strcmp(log_repeat.message, message)) {
+		log_repeat.time = time;
+		log_repeat.count++;
+		return;
+	}
+	logWriteRepeat();
+
+	fprintf(log_file, "[%.2d:%.2d:%.2d][%s] %s\n", time.wHour, time.wMinute, time.wSecond, (type == 0 ? "INFO" : (type == 1 ? "ERROR" : "WARNING")), message);
+
+	log_repeat.type = type;
+	strncpy_s(log_repeat.message, message, _TRUNCATE);
+}
+
+void logWriteRepeat()
+{
+	if (!log_repeat.count)
+		return;
+
+	const auto& time = log_repeat.time;
+	fprintf(log_file, "[%.2d:%.2d:%.2d][%s] Last message repeated %u times.\n", time.wHour, time.wMinute, time.wSecond, (log_repeat.type == 0 ? "INFO" : (log_repeat.type == 1 ? "ERROR" : "WARNING")), log_repeat.count);
+	log_repeat.count = 0;
+}
+
+LONG WINAPI logExceptionFilter(EXCEPTION_POINTERS* info)
+{
+	logFileWrite(1, "Unhandled exception 0x%08X at 0x%p.", info->ExceptionRecord->ExceptionCode, info->ExceptionRecord->ExceptionAddress);
+	logFlush();
+
+	return log_prev_filter ? log_prev_filter(info) : EXCEPTION_CONTINUE_SEARCH;
 }
 
 }
\ No newline at end of file
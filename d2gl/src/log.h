@@ -24,9 +24,8 @@ void logInit();
 void logTrace(WORD color, bool newline, const char* format, ...);
 void logTraceDef(uint8_t type, const char* format, ...);
 
-bool logFileOpen(const char* mode);
 void logFileWrite(uint8_t type, const char* format, ...);
-void logFileClose();
+void logFlush();
 
 // clang-format off
 #define C_GRAY    FOREGROUND_INTENSITY
@@ -21,13 +21,13 @@
 #include "d2/common.h"
 #include "d2/funcs.h"
 #include "helpers.h"
+#include "image_decoder.h"
 
 namespace d2gl::modules {
 
-CursorObject::CursorObject(const std::unique_ptr<Texture>& texture, const std::string& file_name, uint32_t frames, glm::vec2 offset)
+CursorObject::CursorObject(const std::unique_ptr<Texture>& texture, ImageData image_data, uint32_t frames, glm::vec2 offset)
 	: m_offset(offset)
 {
-	auto image_data = helpers::loadImage(file_name);
 	auto tex_data = texture->fillImage(image_data, frames);
 	helpers::clearImage(image_data);
 
@@ -47,6 +47,10 @@ void CursorObject::draw(uint8_t frame)
 
 HDCursor::HDCursor()
 {
+	ImageDecoder image_decoder;
+	image_decoder.add("assets\\textures\\cursor\\hand.png");
+	image_decoder.add("assets\\textures\\cursor\\other.png");
+
 	TextureCreateInfo texture_ci;
 	texture_ci.size = { 128, 128 };
 	texture_ci.layer_count = 50;
@@ -54,8 +58,8 @@ HDCursor::HDCursor()
 	texture_ci.filter = { GL_LINEAR, GL_LINEAR };
 	m_texture = Context::createTexture(texture_ci);
 
-	m_hand_cursor = std::make_unique<CursorObject>(m_texture, "assets\\textures\\cursor\\hand.png", 19, glm::vec2(1.0f, 6.0f));
-	m_other_cursor = std::make_unique<CursorObject>(m_texture, "assets\\textures\\cursor\\other.png", 10, glm::vec2(1.0f, 6.0f));
+	m_hand_cursor = std::make_unique<CursorObject>(m_texture, image_decoder.get(0), 19, glm::vec2(1.0f, 6.0f));
+	m_other_cursor = std::make_unique<CursorObject>(m_texture, image_decoder.get(1), 10, glm::vec2(1.0f, 6.0f));
 }
 
 void HDCursor::draw()
@@ -37,7 +37,7 @@ class CursorObject {
 	glm::vec2 m_offset;
 
 public:
-	CursorObject(const std::unique_ptr<Texture>& texture, const std::string& file_name, uint32_t frames, glm::vec2 offset);
+	CursorObject(const std::unique_ptr<Texture>& texture, ImageData image_data, uint32_t frames, glm::vec2 offset);
 	~CursorObject() = default;
 
 	void draw(uint8_t frame);
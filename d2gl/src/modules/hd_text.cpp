@@ -20,6 +20,7 @@
 #include "hd_text.h"
 #include "d2/common.h"
 #include "d2/stubs.h"
+#include "modules/hd_text/font_atlas.h"
 #include "modules/mini_map.h"
 #include "modules/motion_prediction.h"
 #include "option/menu.h"
@@ -33,15 +34,13 @@ HDText::HDText()
 
 	std::string lang_file = helpers::getLangString(true);
 	auto buffer = helpers::loadFile("assets\\atlases\\" + lang_file + ".txt");
-	if (!buffer.size && m_lang_id == LANG_SIN)
+	if (!buffer && m_lang_id == LANG_SIN)
 		buffer = helpers::loadFile("assets\\atlases\\chi.txt");
-	if (!buffer.size)
+	if (!buffer)
 		buffer = helpers::loadFile("assets\\atlases\\default.txt");
 
-	if (buffer.size) {
-		std::string data((const char*)buffer.data, buffer.size);
-		auto lines = helpers::strToLines(data);
-		delete[] buffer.data;
+	if (buffer) {
+		auto lines = helpers::strToLines(buffer->getString());
 
 		TextureCreateInfo texture_ci;
 		texture_ci.layer_count = 1;
@@ -50,7 +49,35 @@ HDText::HDText()
 		texture_ci.filter = { GL_LINEAR, GL_LINEAR };
 
 		static std::unordered_map<std::string, GlyphSet*> glyph_sets;
+		std::unordered_map<std::string, AssetRef> baked_sets;
 		std::vector<std::vector<std::string>> info_list;
+
+		auto loadBaked = [&](const std::string& name) {
+			auto baked = helpers::loadFile("assets\\atlases\\" + name + "\\atlas.bin", false);
+			if (!baked)
+				return 0u;
+
+			auto header = font_atlas::getHeader(baked->getData(), baked->getSize());
+			if (!header)
+				return 0u;
+
+			// Glyph coords are normalized to the texture array, other layer sizes fall back to data.csv.
+			if (header->layer_width != texture_ci.size.x || header->layer_height != texture_ci.size.y) {
+				error_log("Baked atlas %s has %ux%u layers, expected %ux%u.", name.c_str(), header->layer_width, header->layer_height, texture_ci.size.x, texture_ci.size.y);
+				return 0u;
+			}
+
+			baked_sets[name] = baked;
+			return header->layer_count;
+		};
+		auto getBaked = [&](const std::string& name) -> const Asset* {
+			const auto it = baked_sets.find(name);
+			return it != baked_sets.end() ? it->second.get() : nullptr;
+		};
+		const uint32_t symbol_layers = loadBaked("NotoSymbol");
+		if (symbol_layers)
+			texture_ci.layer_count = symbol_layers;
+
 		for (auto& line : lines) {
 			helpers::replaceAll(line, " ", "");
 			helpers::replaceAll(line, "\r", "");
@@ -58,15 +85,16 @@ HDText::HDText()
 			auto info = helpers::splitToVector(line, '|');
 			if (info.size() > 9) {
 				if (glyph_sets.find(info[1]) == glyph_sets.end()) {
-					auto buffer2 = helpers::loadFile("assets\\atlases\\" + info[1] + "\\data.csv");
-					if (buffer2.size) {
-						auto pos = (buffer2.data + (buffer2.size - 5));
-						while (*pos != '\n' || pos == buffer2.data)
+					const uint32_t baked_layers = loadBaked(info[1]);
+					texture_ci.layer_count += baked_layers;
+					auto buffer2 = baked_layers ? nullptr : helpers::loadFile("assets\\atlases\\" + info[1] + "\\data.csv");
+					if (buffer2 && buffer2->getSize()) {
+						auto pos = (buffer2->getData() + (buffer2->getSize() - 5));
+						while (*pos != '\n' || pos == buffer2->getData())
 							pos--;
 						std::string num = std::string((const char*)(pos + 1), 2);
 						helpers::replaceAll(num, ",", "");
 						texture_ci.layer_count += std::atoi(num.c_str()) + 1;
-						delete[] buffer2.data;
 					}
 					glyph_sets.insert({ info[1], nullptr });
 				}
@@ -75,12 +103,12 @@ HDText::HDText()
 		}
 
 		static std::unique_ptr<Texture> texture = Context::createTexture(texture_ci);
-		static auto symbol_set = new GlyphSet(texture.get(), "NotoSymbol");
+		static auto symbol_set = new GlyphSet(texture.get(), "NotoSymbol", nullptr, getBaked("NotoSymbol"));
 
 		for (auto& info : info_list) {
 			const auto name = info[1];
 			if (!glyph_sets[name])
-				glyph_sets[name] = new GlyphSet(texture.get(), name, symbol_set);
+				glyph_sets[name] = new GlyphSet(texture.get(), name, symbol_set, getBaked(name));
 
 			uint8_t id = (uint8_t)std::atoi(info[0].c_str());
 			bool bordered = (id == 2 || id == 3 || id == 7 || id == 18);
@@ -32,38 +32,47 @@ Font::Font(GlyphSet* glyph_set, const FontCreateInfo& font_ci)
 
 glm::vec2 Font::getTextSize(const wchar_t* str, const int max_chars)
 {
+	const uint64_t key = ((uint64_t)helpers::hash(str, wcslen(str) * sizeof(wchar_t)) << 32) | (uint32_t)max_chars;
+	if (auto it = m_metrics_cache.find(key); it != m_metrics_cache.end() && it->second.text == str) {
+		auto& metrics = it->second;
+		metrics.last_frame = App.context->getFrameCount();
+		m_line_count = metrics.line_count;
+		std::copy(metrics.line_width.begin(), metrics.line_width.end(), m_line_width);
+		m_text_size = metrics.size;
+		return m_text_size;
+	}
+
 	m_text_size = { 0.0f, 0.0f };
 	const float line_height = getLineHeight();
 	const float letter_spacing = getLetterSpacing();
 
 	float advance = 0.0f;
-	int char_num = 0;
 	int line_num = 0;
 
-	while (str[char_num] != L'\0') {
-		if (str[char_num] == L'ÿ' && str[char_num + 1] == L'c') {
-			const auto color_code = str[char_num + 2];
-			if (g_text_colors.find(color_code) != g_text_colors.end()) {
-				char_num += 3;
-				continue;
-			}
-		}
-		if (str[char_num] == L'\n') {
-			m_line_width[line_num] = advance;
-			m_text_size.x = glm::max(m_text_size.x, advance);
-			if (str[char_num + 1] != L'\0') {
-				m_text_size.y += line_height;
-				advance = 0.0f;
-				line_num++;
+	TextSpan span;
+	TextTokenizer tokenizer(str);
+	while (tokenizer.next(span)) {
+		const wchar_t* c = span.str;
+		const wchar_t* end = span.str + span.len;
+		for (; c < end; c++) {
+			if (*c == L'\n') {
+				m_line_width[line_num] = advance;
+				m_text_size.x = glm::max(m_text_size.x, advance);
+				if (c[1] != L'\0') {
+					m_text_size.y += line_height;
+					advance = 0.0f;
+					line_num++;
+				}
+			} else if (auto glyph = m_glyph_set->getGlyph(*c)) {
+				advance += glyph->advance * m_scale;
+				if (c[1] != L'\n' && c[1] != L'\0')
+					advance += letter_spacing;
 			}
-		} else if (auto glyph = m_glyph_set->getGlyph(str[char_num])) {
-			advance += glyph->advance * m_scale;
-			if (str[char_num + 1] != L'\n' && str[char_num + 1] != L'\0')
-				advance += letter_spacing;
+			if (max_chars > 0 && max_chars < (int)(c - str))
+				break;
 		}
-		if (max_chars > 0 && max_chars < char_num)
+		if (c < end)
 			break;
-		char_num++;
 	}
 
 	m_line_count = line_num + 1;
@@ -71,10 +80,43 @@ glm::vec2 Font::getTextSize(const wchar_t* str, const int max_chars)
 	m_text_size.x = glm::max(m_text_size.x, advance);
 	m_text_size.y += line_height - (line_height - m_font_size);
 
+	trimCache(m_metrics_cache);
+	auto& metrics = m_metrics_cache[key];
+	metrics.text = str;
+	metrics.size = m_text_size;
+	metrics.line_count = m_line_count;
+	metrics.line_width.assign(m_line_width, m_line_width + glm::min(m_line_count, 100u));
+	metrics.last_frame = App.context->getFrameCount();
+
 	return m_text_size;
 }
 
 void Font::drawText(const wchar_t* str, glm::vec2 pos, uint32_t color, bool framed)
+{
+	TextRunParams params;
+	const uint64_t key = getRunKey(str, color, framed, params);
+	auto it = m_run_cache.find(key);
+	if (it == m_run_cache.end() || it->second.text != str || !(it->second.params == params)) {
+		if (it == m_run_cache.end()) {
+			trimCache(m_run_cache);
+			it = m_run_cache.try_emplace(key).first;
+		}
+		m_run = &it->second;
+		m_run->text = str;
+		m_run->params = params;
+		m_run->instances.clear();
+		layoutText(str, color, framed);
+		m_run = nullptr;
+	}
+
+	auto& run = it->second;
+	run.last_frame = App.context->getFrameCount();
+	if (!run.instances.empty())
+		App.context->pushInstances(run.instances.data(), (uint32_t)run.instances.size(), pos);
+	m_line_count = 0;
+}
+
+void Font::layoutText(const wchar_t* str, uint32_t color, bool framed)
 {
 	const auto line_height = getLineHeight();
 	const auto letter_spacing = getLetterSpacing();
@@ -107,45 +149,44 @@ void Font::drawText(const wchar_t* str, glm::vec2 pos, uint32_t color, bool fram
 		m_object->setColor(color2, 2);
 	}
 
-	int char_num = 0;
 	int line_num = 0;
 	int trans_mask = 0x00000000;
-	while (str[char_num] != L'\0') {
-		if (str[char_num] == L'ÿ' && str[char_num + 1] == L'c') {
-			const auto color_code = str[char_num + 2];
-			if (g_text_colors.find(color_code) != g_text_colors.end()) {
-				if (color_code == L'\x40' || color_code == L'\x41' || color_code == L'\x42' || color_code == L'\x43') {
-					trans_mask = g_text_colors.at(color_code);
+
+	TextSpan span;
+	TextTokenizer tokenizer(str);
+	while (tokenizer.next(span)) {
+		if (span.color) {
+			if (span.color == L'\x40' || span.color == L'\x41' || span.color == L'\x42' || span.color == L'\x43') {
+				trans_mask = g_text_colors.at(span.color);
+				char_color &= 0xFFFFFF00;
+				char_color |= trans_mask;
+			} else {
+				char_color = g_text_colors.at(span.color);
+				if (trans_mask) {
 					char_color &= 0xFFFFFF00;
 					char_color |= trans_mask;
-				} else {
-					char_color = g_text_colors.at(color_code);
-					if (trans_mask) {
-						char_color &= 0xFFFFFF00;
-						char_color |= trans_mask;
-					}
 				}
-				char_num += 3;
-				continue;
 			}
 		}
-		if (str[char_num] == L'\n') {
-			offset.x = text_offset.x;
-			offset.y -= line_height;
 
-			if (str[char_num + 1] == L'\0')
-				break;
-			line_num++;
-
-			if (m_align == TextAlign::Right)
-				offset.x += m_text_size.x - m_line_width[line_num];
-			else if (m_align == TextAlign::Center)
-				offset.x += (m_text_size.x - m_line_width[line_num]) / 2.0f;
-		} else
-			offset.x += drawChar(str[char_num], pos + offset, char_color) + letter_spacing;
-		char_num++;
+		const wchar_t* end = span.str + span.len;
+		for (const wchar_t* c = span.str; c < end; c++) {
+			if (*c == L'\n') {
+				offset.x = text_offset.x;
+				offset.y -= line_height;
+
+				if (c[1] == L'\0')
+					return;
+				line_num++;
+
+				if (m_align == TextAlign::Right)
+					offset.x += m_text_size.x - m_line_width[line_num];
+				else if (m_align == TextAlign::Center)
+					offset.x += (m_text_size.x - m_line_width[line_num]) / 2.0f;
+			} else
+				offset.x += drawChar(*c, offset, char_color) + letter_spacing;
+		}
 	}
-	m_line_count = 0;
 }
 
 float Font::drawChar(wchar_t c, glm::vec2 pos, uint32_t color)
@@ -167,14 +208,9 @@ float Font::drawChar(wchar_t c, glm::vec2 pos, uint32_t color)
 		m_object->setPosition(object_pos);
 		m_object->setColor(color);
 
-		if (m_shadow_level > 0) {
-			m_object->setExtra({ m_shadow_intensity, 0.0f });
-			m_object->setFlags(3, m_shadow_level, m_masking);
-			App.context->pushObject(m_object);
-		}
-		m_object->setExtra({ m_smoothness, weight });
-		m_object->setFlags(3, 0, m_masking, m_bordered);
-		App.context->pushObject(m_object);
+		m_object->setExtra({ m_smoothness, weight, m_shadow_intensity, 0.0f });
+		m_object->setFlags(3, m_shadow_level, m_masking, m_bordered);
+		m_run->instances.push_back(*m_object->getInstance());
 
 		return glyph->advance * m_scale;
 	}
@@ -182,6 +218,41 @@ float Font::drawChar(wchar_t c, glm::vec2 pos, uint32_t color)
 	return 0.0f;
 }
 
+uint64_t Font::getRunKey(const wchar_t* str, uint32_t color, bool framed, TextRunParams& params)
+{
+	const bool aligned = framed || m_align != TextAlign::Left;
+	params = {
+		aligned ? m_text_size : glm::vec2(0.0f),
+		aligned ? m_line_count : 0,
+		color,
+		m_opacity,
+		(uint8_t)m_align,
+		m_shadow_level,
+		(uint8_t)m_masking,
+		(uint8_t)framed,
+	};
+
+	return ((uint64_t)helpers::hash(str, wcslen(str) * sizeof(wchar_t)) << 32) | helpers::hash(&params, sizeof(params));
+}
+
+template <typename T>
+void Font::trimCache(std::unordered_map<uint64_t, T>& cache)
+{
+	if (cache.size() < TEXT_RUN_CACHE_SIZE)
+		return;
+
+	const uint32_t frame = App.context->getFrameCount();
+	for (auto it = cache.begin(); it != cache.end();) {
+		if (frame - it->second.last_frame > TEXT_RUN_MAX_AGE)
+			it = cache.erase(it);
+		else
+			++it;
+	}
+
+	if (cache.size() >= TEXT_RUN_CACHE_SIZE)
+		cache.clear();
+}
+
 #ifdef _HDTEXT
 void Font::updateMetrics()
 {
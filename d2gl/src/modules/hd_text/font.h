@@ -23,6 +23,73 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 namespace d2gl {
 
+#define TEXT_RUN_CACHE_SIZE 1024
+#define TEXT_RUN_MAX_AGE 120
+
+// Cache keys are hashes, entries keep the text and parameters they were built from to rule out collisions.
+struct TextMetrics {
+	std::wstring text;
+	glm::vec2 size = { 0.0f, 0.0f };
+	uint32_t line_count = 0;
+	std::vector<float> line_width; // first 100 lines only
+	uint32_t last_frame = 0;
+};
+
+struct TextRunParams {
+	glm::vec2 text_size = { 0.0f, 0.0f };
+	uint32_t line_count = 0;
+	uint32_t color = 0;
+	float opacity = 0.0f;
+	uint8_t align = 0;
+	uint8_t shadow_level = 0;
+	uint8_t masking = 0;
+	uint8_t framed = 0;
+
+	inline bool operator==(const TextRunParams& other) const { return memcmp(this, &other, sizeof(TextRunParams)) == 0; }
+};
+
+struct TextRun {
+	std::wstring text;
+	TextRunParams params;
+	std::vector<InstanceMod> instances;
+	uint32_t last_frame = 0;
+};
+
+struct TextSpan {
+	wchar_t color = 0;
+	const wchar_t* str = nullptr;
+	uint32_t len = 0;
+};
+
+class TextTokenizer {
+	const wchar_t* m_ptr;
+
+public:
+	TextTokenizer(const wchar_t* str) : m_ptr(str) {}
+
+	inline bool next(TextSpan& span)
+	{
+		if (*m_ptr == L'\0')
+			return false;
+
+		span.color = 0;
+		if (isColorCode(m_ptr)) {
+			span.color = m_ptr[2];
+			m_ptr += 3;
+		}
+
+		span.str = m_ptr;
+		while (*m_ptr != L'\0' && !isColorCode(m_ptr))
+			m_ptr++;
+		span.len = (uint32_t)(m_ptr - span.str);
+
+		return true;
+	}
+
+private:
+	static inline bool isColorCode(const wchar_t* str) { return str[0] == L'\xFF' && str[1] == L'c' && g_text_colors.has(str[2]); }
+};
+
 struct FontCreateInfo {
 	std::string name;
 	float size = 0.0f;
@@ -64,11 +131,16 @@ class Font {
 	uint32_t m_line_count = 0;
 	bool m_masking = false;
 
+	std::unordered_map<uint64_t, TextMetrics> m_metrics_cache;
+	std::unordered_map<uint64_t, TextRun> m_run_cache;
+	TextRun* m_run = nullptr;
+
 public:
 	Font(GlyphSet* glyph_set, const FontCreateInfo& font_ci);
 	~Font() = default;
 
-	inline void setSize() { m_font_size = m_size * App.hd_text.scale.value, m_scale = m_font_size / 32.0f, m_smoothness = m_font_size; }
+	inline void setSize() { m_font_size = m_size * App.hd_text.scale.value, m_scale = m_font_size / 32.0f, m_smoothness = m_font_size, clearCache(); }
+	inline void clearCache() { m_metrics_cache.clear(), m_run_cache.clear(); }
 	inline void setAlign(TextAlign align) { m_align = align; }
 	inline void setShadow(uint8_t level = 0) { m_shadow_level = level; }
 	inline void setMasking(bool masking) { m_masking = masking; }
@@ -86,7 +158,12 @@ public:
 	void drawText(const wchar_t* str, glm::vec2 pos, uint32_t color, bool framed = false);
 
 private:
+	void layoutText(const wchar_t* str, uint32_t color, bool framed);
 	float drawChar(wchar_t c, glm::vec2 pos, uint32_t color);
+	uint64_t getRunKey(const wchar_t* str, uint32_t color, bool framed, TextRunParams& params);
+
+	template <typename T>
+	void trimCache(std::unordered_map<uint64_t, T>& cache);
 
 #ifdef _HDTEXT
 public:
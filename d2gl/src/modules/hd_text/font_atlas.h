@@ -0,0 +1,82 @@
+/*
+D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+Copyright (C) 2023  Bayaraa
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Baked glyph set written by tools/font_bake: header, glyph table, then layer_count RGBA8 layers
+// stored bottom-up (same orientation as helpers::loadImage) so they can be uploaded as is.
+
+namespace d2gl {
+
+#define FONT_ATLAS_MAGIC 0x41463244 // "D2FA"
+#define FONT_ATLAS_VERSION 1
+
+struct FontAtlasHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t glyph_count;
+	uint32_t layer_count;
+	uint32_t layer_width;
+	uint32_t layer_height;
+};
+
+struct FontAtlasGlyph {
+	uint32_t code;
+	uint32_t layer;
+	float advance;
+	float size[2];
+	float offset[2];
+	float tex_coord[4];
+};
+
+namespace font_atlas {
+
+inline size_t getLayerSize(const FontAtlasHeader* header)
+{
+	return (size_t)header->layer_width * header->layer_height * 4;
+}
+
+inline const FontAtlasHeader* getHeader(const uint8_t* data, size_t size)
+{
+	if (!data || size < sizeof(FontAtlasHeader))
+		return nullptr;
+
+	const auto header = (const FontAtlasHeader*)data;
+	if (header->magic != FONT_ATLAS_MAGIC || header->version != FONT_ATLAS_VERSION)
+		return nullptr;
+
+	const size_t total = sizeof(FontAtlasHeader) + header->glyph_count * sizeof(FontAtlasGlyph) + header->layer_count * getLayerSize(header);
+	return total <= size ? header : nullptr;
+}
+
+inline const FontAtlasGlyph* getGlyphs(const FontAtlasHeader* header)
+{
+	return (const FontAtlasGlyph*)(header + 1);
+}
+
+inline const uint8_t* getLayer(const FontAtlasHeader* header, uint32_t index)
+{
+	return (const uint8_t*)(getGlyphs(header) + header->glyph_count) + index * getLayerSize(header);
+}
+
+}
+
+}
@@ -18,29 +18,51 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "pch.h"
 #include "glyph_set.h"
+#include "font_atlas.h"
 #include "helpers.h"
+#include "image_decoder.h"
 
 namespace d2gl {
 
-GlyphSet::GlyphSet(Texture* texture, const std::string& name, GlyphSet* symbol_set)
-	: m_symbols(symbol_set ? symbol_set->getGlyphes() : nullptr)
+GlyphSet::GlyphSet(Texture* texture, const std::string& name, GlyphSet* symbol_set, const Asset* baked)
+{
+	if (baked)
+		loadBaked(texture, *baked);
+	else
+		loadData(texture, name);
+
+	buildTable(symbol_set);
+}
+
+void GlyphSet::loadData(Texture* texture, const std::string& name)
 {
 	auto buffer = helpers::loadFile("assets\\atlases\\" + name + "\\data.csv");
-	if (!buffer.size)
+	if (!buffer)
 		return;
 
+	std::vector<std::vector<std::string>> rows;
+	for (auto& line : helpers::strToLines(buffer->getString()))
+		rows.push_back(helpers::splitToVector(line));
+
+	// All atlas pages are queued first, then uploaded in order as they finish decoding.
+	ImageDecoder image_decoder;
 	int atlas_index = -1;
-	uint32_t start_layer = 0;
-	std::string data((const char*)buffer.data, buffer.size);
-	auto lines = helpers::strToLines(data);
-	delete[] buffer.data;
+	for (auto& cols : rows) {
+		auto index = std::atoi(cols[0].c_str());
+		if (atlas_index < index) {
+			image_decoder.add("assets\\atlases\\" + name + "\\" + cols[0] + ".png");
+			atlas_index = index;
+		}
+	}
 
-	for (auto& line : lines) {
-		auto cols = helpers::splitToVector(line);
+	atlas_index = -1;
+	size_t page = 0;
+	uint32_t start_layer = 0;
 
+	for (auto& cols : rows) {
 		auto index = std::atoi(cols[0].c_str());
 		if (atlas_index < index) {
-			auto image_data = helpers::loadImage("assets\\atlases\\" + name + "\\" + cols[0] + ".png");
+			auto image_data = image_decoder.get(page++);
 			auto tex_data = texture->fillImage(image_data);
 			helpers::clearImage(image_data);
 			start_layer = tex_data.start_layer;
@@ -59,28 +81,68 @@ GlyphSet::GlyphSet(Texture* texture, const std::string& name, GlyphSet* symbol_s
 	}
 }
 
-const Glyph* GlyphSet::getGlyph(wchar_t c)
+void GlyphSet::loadBaked(Texture* texture, const Asset& baked)
 {
-	m_is_symbol = false;
-	if (m_glyphes.find(c) != m_glyphes.end())
-		return &m_glyphes[c];
+	const auto header = font_atlas::getHeader(baked.getData(), baked.getSize());
+	if (!header || header->layer_width != texture->getWidth() || header->layer_height != texture->getHeight())
+		return;
 
-	if (c == L'\xa0')
-		return &m_glyphes[L' '];
+	uint32_t start_layer = 0;
+	for (uint32_t i = 0; i < header->layer_count; i++) {
+		ImageData image = { (int)header->layer_width, (int)header->layer_height, 4, (uint8_t*)font_atlas::getLayer(header, i) };
+		auto tex_data = texture->fillImage(image);
+		if (i == 0)
+			start_layer = tex_data.start_layer;
+	}
 
-	if (m_symbols) {
-		m_is_symbol = true;
-		if (m_symbols->find(c) != m_symbols->end())
-			return &m_symbols->at(c);
+	const auto glyphs = font_atlas::getGlyphs(header);
+	for (uint32_t i = 0; i < header->glyph_count; i++) {
+		auto& glyph = m_glyphes[(wchar_t)glyphs[i].code];
+		glyph.advance = glyphs[i].advance;
+		glyph.size = { glyphs[i].size[0], glyphs[i].size[1] };
+		glyph.offset = { glyphs[i].offset[0], glyphs[i].offset[1] };
+		glyph.tex_id = start_layer + glyphs[i].layer;
+		glyph.tex_coord = { glyphs[i].tex_coord[0], glyphs[i].tex_coord[1], glyphs[i].tex_coord[2], glyphs[i].tex_coord[3] };
+	}
+}
 
-		if (c > 0x20)
-			return &m_symbols->at(L'☹');
+// Resolves own glyphs, symbol fallbacks and replacement characters once, so lookups are a page index plus an entry load.
+void GlyphSet::buildTable(GlyphSet* symbol_set)
+{
+	if (symbol_set) {
+		for (auto& glyph : *symbol_set->getGlyphes())
+			setEntry(glyph.first, { &glyph.second, true });
 	}
 
-	if (c > 0x20)
-		return &m_glyphes[L'?'];
+	for (auto& glyph : m_glyphes)
+		setEntry(glyph.first, { &glyph.second, false });
+
+	if (m_glyphes.find(L'\xa0') == m_glyphes.end()) {
+		const auto space = m_glyphes.find(L' ');
+		if (space != m_glyphes.end())
+			setEntry(L'\xa0', { &space->second, false });
+	}
+
+	const auto question = m_glyphes.find(L'?');
+	if (question != m_glyphes.end())
+		m_fallback = { &question->second, false };
+
+	if (symbol_set) {
+		const auto symbols = symbol_set->getGlyphes();
+		const auto sad_face = symbols->find(L'☹');
+		if (sad_face != symbols->end())
+			m_fallback = { &sad_face->second, true };
+	}
+}
+
+void GlyphSet::setEntry(wchar_t c, const GlyphEntry& entry)
+{
+	const uint16_t code = (uint16_t)c;
+	auto& page = m_pages[code >> 8];
+	if (!page)
+		page = std::make_unique<GlyphPage>();
 
-	return nullptr;
+	(*page)[code & 0xFF] = entry;
 }
 
 }
\ No newline at end of file
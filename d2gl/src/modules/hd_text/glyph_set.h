@@ -20,6 +20,8 @@ along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 namespace d2gl {
 
+class Asset;
+
 struct Glyph {
 	glm::vec2 size = { 0.0f, 0.0f };
 	glm::vec2 offset = { 0.0f, 0.0f };
@@ -28,18 +30,41 @@ struct Glyph {
 	glm::vec4 tex_coord = { 0.0f, 0.0f, 0.0f, 0.0f };
 };
 
+struct GlyphEntry {
+	const Glyph* glyph = nullptr;
+	bool symbol = false;
+};
+
+typedef std::array<GlyphEntry, 256> GlyphPage;
+
 class GlyphSet {
 	std::map<wchar_t, Glyph> m_glyphes;
-	std::map<wchar_t, Glyph>* m_symbols = nullptr;
+	std::array<std::unique_ptr<GlyphPage>, 256> m_pages;
+	GlyphEntry m_fallback;
+	GlyphEntry m_empty;
 	bool m_is_symbol = false;
 
 public:
-	GlyphSet(Texture* texture, const std::string& name, GlyphSet* symbol_set = nullptr);
+	GlyphSet(Texture* texture, const std::string& name, GlyphSet* symbol_set = nullptr, const Asset* baked = nullptr);
 	~GlyphSet() = default;
 
-	const Glyph* getGlyph(wchar_t c);
+	inline const Glyph* getGlyph(wchar_t c)
+	{
+		const uint16_t code = (uint16_t)c;
+		const auto& page = m_pages[code >> 8];
+		const GlyphEntry& entry = page && (*page)[code & 0xFF].glyph ? (*page)[code & 0xFF] : (code > 0x20 ? m_fallback : m_empty);
+		m_is_symbol = entry.symbol;
+		return entry.glyph;
+	}
+
 	inline bool isSymbol() { return m_is_symbol; }
 	inline std::map<wchar_t, Glyph>* getGlyphes() { return &m_glyphes; }
+
+private:
+	void loadData(Texture* texture, const std::string& name);
+	void loadBaked(Texture* texture, const Asset& baked);
+	void buildTable(GlyphSet* symbol_set);
+	void setEntry(wchar_t c, const GlyphEntry& entry);
 };
 
 }
\ No newline at end of file
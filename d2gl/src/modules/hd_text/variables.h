@@ -45,8 +45,13 @@ struct D2TextMetrics {
 	glm::vec<2, uint8_t> entry_text;
 };
 
+struct TextColor {
+	wchar_t code;
+	uint32_t color;
+};
+
 // clang-format off
-inline const std::map<wchar_t, uint32_t> g_text_colors = {
+inline constexpr TextColor g_text_color_list[] = {
 	{ L'\x01', 0xDFB679FF }, { L'\x02', 0x000000FF }, { L'\x03', 0xDFB67966 }, { L'\x04', 0xC22121FF },
 	{ L'\x05', 0x959595FF }, { L'\x06', 0xE09595FF }, { L'\x07', 0xB6E12EFF }, { L'\x08', 0x9EA0A0FF },
 	{ L'\x09', 0x5CA6A4FF }, { L'\x0A', 0xA2AAA5FF }, { L'\x0B', 0xA6E0A7FF }, { L'\x0C', 0xA9A9B0FF },
@@ -64,7 +69,25 @@ inline const std::map<wchar_t, uint32_t> g_text_colors = {
 	{ L'\x3A', 0x008C00FF }, { L'\x3B', 0xB700FFFF }, { L'\x3C', 0x00D200FF }, { L'\x3D', 0xEBEBEBFF },
 	{ L'\x40', 0x000000FF }, { L'\x41', 0x00000099 }, { L'\x42', 0x00000066 }, { L'\x43', 0x00000033 }, // special cases, apply transparency to rest of the text
 };
+// clang-format on
+
+class TextColorTable {
+	uint64_t m_entries[256] = { 0 };
+
+public:
+	constexpr TextColorTable()
+	{
+		for (const auto& text_color : g_text_color_list)
+			m_entries[text_color.code & 0xFF] = (1ull << 32) | text_color.color;
+	}
 
+	constexpr bool has(wchar_t code) const { return (uint32_t)code < 256 && (m_entries[code] >> 32); }
+	constexpr uint32_t at(wchar_t code) const { return (uint32_t)code < 256 ? (uint32_t)m_entries[code] : 0; }
+};
+
+inline constexpr TextColorTable g_text_colors;
+
+// clang-format off
 inline const std::array<wchar_t, 18> g_default_colors = {
 	L'\x30', // 0.White (Item Descriptions)
 	L'\x31', // 1.Red
@@ -83,6 +83,8 @@ void MotionPrediction::toggle(bool active)
 
 void MotionPrediction::update()
 {
+	m_particles.updateStats(App.context->getFrameTime());
+
 	if (!isAvailable()) {
 		m_global_offset = { 0, 0 };
 		m_player_motion.offset = { 0, 0 };
@@ -97,6 +99,13 @@ void MotionPrediction::update()
 	m_player_motion.unit = d2::getPlayerUnit();
 	setUnitMotion(&m_player_motion, delta);
 
+#ifdef _DEBUG
+	if (m_record_file.is_open()) {
+		const d2::Path* path = d2::getUnitPath(m_player_motion.unit);
+		m_record_file << App.context->getFrameTime() << " " << delta << " " << (int32_t)path->x << " " << (int32_t)path->y << "\n";
+	}
+#endif
+
 	const auto frame = App.context->getFrameCount() - 1;
 	for (auto it = m_units.begin(); it != m_units.end();) {
 		if (it->second.frame != frame)
@@ -114,6 +123,19 @@ void MotionPrediction::update()
 	m_global_offset = getUnitOffset(&m_player_motion);
 }
 
+#ifdef _DEBUG
+void MotionPrediction::toggleRecording(bool record)
+{
+	if (record && !m_record_file.is_open()) {
+		m_record_file.open("motion_trace.txt", std::ios::trunc);
+		trace("Motion trace recording started.");
+	} else if (!record && m_record_file.is_open()) {
+		m_record_file.close();
+		trace("Motion trace recording stopped.");
+	}
+}
+#endif
+
 glm::ivec2 MotionPrediction::getGlobalOffset(bool skip)
 {
 	if (App.game.draw_stage == DrawStage::World && (!skip || !m_perspective))
@@ -193,36 +215,34 @@ glm::ivec2 MotionPrediction::drawLine(int start_x, int start_y)
 	if (!isAvailable() || !d2::currently_drawing_weather_particles)
 		return { 0, 0 };
 
-	uint32_t particle_index = *d2::currently_drawing_weather_particle_index_ptr;
-	if (particle_index == m_last_particle_index)
-		particle_index += 256;
-
+	bool created = false;
 	const auto frame = App.context->getFrameCount();
-	ParticleMotion& particle = m_particles[particle_index & 511];
-	m_last_particle_index = particle_index;
+	ParticleMotion* particle = m_particles.get(*d2::currently_drawing_weather_particle_index_ptr, frame, created);
+	if (!particle)
+		return { 0, 0 };
 
-	if (particle.frame != frame) {
+	if (particle->frame != frame || created) {
 		const glm::ivec2 pos = { start_x, start_y };
-		const glm::ivec2 diff = pos - particle.last_pos;
+		const glm::ivec2 diff = pos - particle->last_pos;
 		const int error = glm::max(abs(diff.x), abs(diff.y));
 
-		if (frame - particle.frame > 2 || error > 100) {
-			particle.last_pos = pos;
-			particle.predicted_pos = pos;
-			particle.velocity = { 0.0f, 0.0f };
+		if (created || frame - particle->frame > PARTICLE_MAX_AGE || error > 100) {
+			particle->last_pos = pos;
+			particle->predicted_pos = pos;
+			particle->velocity = { 0.0f, 0.0f };
 		} else {
 			if (error > 0) {
-				particle.velocity = { 25.0f * diff.x, 25.0f * diff.y };
-				particle.last_pos = pos;
+				particle->velocity = { 25.0f * diff.x, 25.0f * diff.y };
+				particle->last_pos = pos;
 			}
 		}
 
-		particle.predicted_pos += particle.velocity * m_frame_time;
-		particle.offset = -glm::ivec2(particle.predicted_pos - particle.last_pos);
-		particle.frame = frame;
+		particle->predicted_pos += particle->velocity * m_frame_time;
+		particle->offset = -glm::ivec2(particle->predicted_pos - particle->last_pos);
+		particle->frame = frame;
 	}
 
-	return particle.offset;
+	return particle->offset;
 }
 
 glm::ivec2 MotionPrediction::drawSolidRect()
@@ -313,66 +333,14 @@ void MotionPrediction::altItemsTextMotion()
 void MotionPrediction::setUnitMotion(UnitMotion* unit_motion, int32_t delta)
 {
 	const d2::Path* path = d2::getUnitPath(unit_motion->unit);
-	const glm::ivec2 unit_pos = { (int32_t)path->x, (int32_t)path->y };
-
-	glm::ivec2 pos_whole = { unit_pos.x >> 16, unit_pos.y >> 16 };
-	glm::ivec2 last_pos_whole = { unit_motion->last_pos.x >> 16, unit_motion->last_pos.y >> 16 };
-	glm::ivec2 predicted_pos_whole = { unit_motion->predicted_pos.x >> 16, unit_motion->predicted_pos.y >> 16 };
-
-	int32_t last_pos_md = std::max(abs(pos_whole.x - last_pos_whole.x), abs(pos_whole.y - last_pos_whole.y));
-	int32_t predicted_pos_md = std::max(abs(pos_whole.x - predicted_pos_whole.x), abs(pos_whole.y - predicted_pos_whole.y));
-
-	if (last_pos_md > 2 || predicted_pos_md > 2) {
-		unit_motion->predicted_pos = unit_pos;
-		unit_motion->corrected_pos = unit_pos;
-		unit_motion->last_pos = unit_pos;
-		unit_motion->velocity = { 0, 0 };
-	}
-
-	const int32_t dx = unit_pos.x - unit_motion->last_pos.x;
-	const int32_t dy = unit_pos.y - unit_motion->last_pos.y;
-
-	unit_motion->dt_last_pos_change += delta;
-
-	if (dx != 0 || dy != 0 || unit_motion->dt_last_pos_change >= (65536 / 25)) {
-		unit_motion->corrected_pos.x = ((int64_t)unit_pos.x + unit_motion->last_pos.x) >> 1;
-		unit_motion->corrected_pos.y = ((int64_t)unit_pos.y + unit_motion->last_pos.y) >> 1;
-
-		unit_motion->velocity.x = 25 * dx;
-		unit_motion->velocity.y = 25 * dy;
-
-		unit_motion->last_pos = unit_pos;
-		unit_motion->dt_last_pos_change = 0;
-	}
-
-	if (unit_motion->velocity.x != 0 || unit_motion->velocity.y != 0) {
-		if (unit_motion->dt_last_pos_change < (65536 / 25)) {
-			glm::ivec2 step = { (int32_t)(((int64_t)delta * unit_motion->velocity.x) >> 16), (int32_t)(((int64_t)delta * unit_motion->velocity.y) >> 16) };
-
-			const int32_t correction = 7000;
-			const int32_t one_minus_correction = 65536 - correction;
-
-			unit_motion->predicted_pos.x = (int32_t)(((int64_t)unit_motion->predicted_pos.x * one_minus_correction + (int64_t)unit_motion->corrected_pos.x * correction) >> 16);
-			unit_motion->predicted_pos.y = (int32_t)(((int64_t)unit_motion->predicted_pos.y * one_minus_correction + (int64_t)unit_motion->corrected_pos.y * correction) >> 16);
-
-			unit_motion->predicted_pos.x += step.x;
-			unit_motion->predicted_pos.y += step.y;
-
-			unit_motion->corrected_pos.x += step.x;
-			unit_motion->corrected_pos.y += step.y;
-		}
-	}
-
+	unit_motion->predictor.update({ (int32_t)path->x, (int32_t)path->y }, delta, m_unit_params);
 	unit_motion->offset_update = true;
 }
 
 glm::ivec2 MotionPrediction::getUnitOffset(UnitMotion* unit_motion)
 {
 	if (unit_motion->offset_update) {
-		const glm::vec2 offset = { (unit_motion->predicted_pos.x - unit_motion->last_pos.x) / 65536.0f, (unit_motion->predicted_pos.y - unit_motion->last_pos.y) / 65536.0f };
-		const glm::vec2 scale_factors = { 32.0f / sqrtf(2.0f), 16.0f / sqrtf(2.0f) };
-		const glm::vec2 screen_offset = scale_factors * glm::vec2(offset.x - offset.y, offset.x + offset.y) + 0.5f;
-		unit_motion->offset = { (int)screen_offset.x, (int)screen_offset.y };
+		unit_motion->offset = unit_motion->predictor.getScreenOffset();
 		unit_motion->offset_update = false;
 	}
 	return unit_motion->offset;
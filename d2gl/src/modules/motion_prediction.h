@@ -19,6 +19,8 @@
 #pragma once
 
 #include "d2/structs.h"
+#include "motion_prediction/particle_table.h"
+#include "motion_prediction/unit_predictor.h"
 
 namespace d2gl::modules {
 
@@ -28,21 +30,7 @@ struct UnitMotion {
 	glm::ivec2 screen_pos = { 0, 0 };
 	glm::ivec2 offset = { 0, 0 };
 	bool offset_update = false;
-
-	glm::ivec2 last_pos = { 0, 0 };
-	glm::ivec2 predicted_pos = { 0, 0 };
-	glm::ivec2 corrected_pos = { 0, 0 };
-	glm::ivec2 velocity = { 0, 0 };
-	int64_t dt_last_pos_change = 0;
-};
-
-struct ParticleMotion {
-	uint32_t frame = 0;
-	glm::ivec2 offset = { 0, 0 };
-
-	glm::ivec2 last_pos = { 0, 0 };
-	glm::ivec2 predicted_pos = { 0, 0 };
-	glm::vec2 velocity = { 0.0f, 0.0f };
+	UnitPredictor predictor;
 };
 
 class MotionPrediction {
@@ -52,13 +40,17 @@ class MotionPrediction {
 
 	std::unordered_map<uint32_t, UnitMotion> m_units;
 	UnitMotion m_player_motion;
+	UnitPredictorParams m_unit_params;
 	bool m_perspective = false;
 
 	D2DrawFn m_text_fn = D2DrawFn::None;
 	D2DrawFn m_draw_fn = D2DrawFn::None;
 
-	std::array<ParticleMotion, 512> m_particles;
-	uint32_t m_last_particle_index = 0;
+	ParticleTable m_particles;
+
+#ifdef _DEBUG
+	std::ofstream m_record_file;
+#endif
 
 	MotionPrediction();
 	~MotionPrediction() = default;
@@ -87,6 +79,13 @@ public:
 	void altItemsTextMotion();
 
 	inline void textMotion(D2DrawFn fn) { m_text_fn = fn; }
+	inline UnitPredictorParams& getUnitParams() { return m_unit_params; }
+	inline const ParticleTableStats& getParticleStats() { return m_particles.getStats(); }
+
+#ifdef _DEBUG
+	void toggleRecording(bool record);
+	inline bool isRecording() { return m_record_file.is_open(); }
+#endif
 
 private:
 	void setUnitMotion(UnitMotion* unit_motion, int32_t delta);
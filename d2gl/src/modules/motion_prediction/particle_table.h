@@ -0,0 +1,120 @@
+/*
+D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+Copyright (C) 2023  Bayaraa
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+namespace d2gl::modules {
+
+#define PARTICLE_TABLE_BITS 13
+#define PARTICLE_TABLE_SIZE (1 << PARTICLE_TABLE_BITS)
+#define PARTICLE_MAX_PROBE 16
+#define PARTICLE_MAX_AGE 2
+#define PARTICLE_STATS_INTERVAL 1000.0
+
+struct ParticleMotion {
+	uint32_t key = UINT32_MAX;
+	uint32_t frame = 0;
+	glm::ivec2 offset = { 0, 0 };
+
+	glm::ivec2 last_pos = { 0, 0 };
+	glm::ivec2 predicted_pos = { 0, 0 };
+	glm::vec2 velocity = { 0.0f, 0.0f };
+};
+
+struct ParticleTableStats {
+	uint32_t lookups = 0;
+	uint32_t inserts = 0;
+	uint32_t evictions = 0;
+	uint32_t overflows = 0;
+	uint32_t max_probe = 0;
+};
+
+// Open addressing table keyed by the game's particle index. The game may draw several lines for the
+// same index in a row, those get their own entry via the repeat counter. Entries not touched for more
+// than PARTICLE_MAX_AGE frames are treated as free.
+class ParticleTable {
+	std::array<ParticleMotion, PARTICLE_TABLE_SIZE> m_slots;
+	ParticleTableStats m_stats;
+	ParticleTableStats m_last_stats;
+	double m_stats_time = 0.0;
+
+	uint32_t m_frame = 0;
+	uint32_t m_last_index = UINT32_MAX;
+	uint32_t m_repeat = 0;
+
+public:
+	inline ParticleMotion* get(uint32_t particle_index, uint32_t frame, bool& created)
+	{
+		if (m_frame != frame) {
+			m_frame = frame;
+			m_last_index = UINT32_MAX;
+		}
+		m_repeat = particle_index == m_last_index ? m_repeat + 1 : 0;
+		m_last_index = particle_index;
+		m_stats.lookups++;
+
+		const uint32_t key = (particle_index << 3) | glm::min(m_repeat, 7u);
+		const uint32_t hash = (key * 2654435761u) >> (32 - PARTICLE_TABLE_BITS);
+
+		ParticleMotion* free_slot = nullptr;
+		for (uint32_t i = 0; i < PARTICLE_MAX_PROBE; i++) {
+			ParticleMotion* slot = &m_slots[(hash + i) & (PARTICLE_TABLE_SIZE - 1)];
+			const bool stale = slot->key == UINT32_MAX || frame - slot->frame > PARTICLE_MAX_AGE;
+
+			if (slot->key == key) {
+				m_stats.max_probe = glm::max(m_stats.max_probe, i);
+				created = stale;
+				if (stale)
+					m_stats.inserts++;
+				return slot;
+			}
+			if (stale && !free_slot)
+				free_slot = slot;
+		}
+
+		if (!free_slot) {
+			m_stats.overflows++;
+			return nullptr;
+		}
+
+		if (free_slot->key != UINT32_MAX)
+			m_stats.evictions++;
+		m_stats.inserts++;
+
+		free_slot->key = key;
+		created = true;
+		return free_slot;
+	}
+
+	// Counters are collected per PARTICLE_STATS_INTERVAL ms, getStats returns the last full interval.
+	inline void updateStats(double frame_time)
+	{
+		m_stats_time += frame_time;
+		if (m_stats_time < PARTICLE_STATS_INTERVAL)
+			return;
+
+		m_last_stats = m_stats;
+		m_stats = {};
+		m_stats_time = 0.0;
+	}
+
+	inline const ParticleTableStats& getStats() { return m_last_stats; }
+};
+
+}
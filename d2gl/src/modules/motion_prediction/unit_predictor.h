@@ -0,0 +1,123 @@
+/*
+D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+Copyright (C) 2023  Bayaraa
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	Part of this file is part of D2DX.
+	https://github.com/bolrog/d2dx/blob/main/src/d2dx/UnitMotionPredictor.cpp
+
+	Copyright (C) 2021  Bolrog
+
+	D2DX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	D2DX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with D2DX. If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+// Kept free of game and Windows dependencies so tools/motion_eval can replay recorded paths offline.
+
+namespace d2gl::modules {
+
+struct UnitPredictorParams {
+	int32_t tick_rate = 25;      // game updates per second
+	int32_t correction = 7000;   // 16.16 blend factor towards corrected position
+	int32_t reset_distance = 2;  // tiles, larger jumps snap instead of predicting
+};
+
+class UnitPredictor {
+	glm::ivec2 m_last_pos = { 0, 0 };
+	glm::ivec2 m_predicted_pos = { 0, 0 };
+	glm::ivec2 m_corrected_pos = { 0, 0 };
+	glm::ivec2 m_velocity = { 0, 0 };
+	int64_t m_dt_last_pos_change = 0;
+
+public:
+	// unit_pos is Path x/y in 16.16 tiles, delta is frame time in 16.16 seconds.
+	inline void update(glm::ivec2 unit_pos, int32_t delta, const UnitPredictorParams& params)
+	{
+		const glm::ivec2 pos_whole = { unit_pos.x >> 16, unit_pos.y >> 16 };
+		const glm::ivec2 last_pos_whole = { m_last_pos.x >> 16, m_last_pos.y >> 16 };
+		const glm::ivec2 predicted_pos_whole = { m_predicted_pos.x >> 16, m_predicted_pos.y >> 16 };
+
+		const int32_t last_pos_md = glm::max(glm::abs(pos_whole.x - last_pos_whole.x), glm::abs(pos_whole.y - last_pos_whole.y));
+		const int32_t predicted_pos_md = glm::max(glm::abs(pos_whole.x - predicted_pos_whole.x), glm::abs(pos_whole.y - predicted_pos_whole.y));
+
+		if (last_pos_md > params.reset_distance || predicted_pos_md > params.reset_distance) {
+			m_predicted_pos = unit_pos;
+			m_corrected_pos = unit_pos;
+			m_last_pos = unit_pos;
+			m_velocity = { 0, 0 };
+		}
+
+		const int32_t dx = unit_pos.x - m_last_pos.x;
+		const int32_t dy = unit_pos.y - m_last_pos.y;
+		const int64_t tick_len = 65536 / params.tick_rate;
+
+		m_dt_last_pos_change += delta;
+
+		if (dx != 0 || dy != 0 || m_dt_last_pos_change >= tick_len) {
+			m_corrected_pos.x = (int32_t)(((int64_t)unit_pos.x + m_last_pos.x) >> 1);
+			m_corrected_pos.y = (int32_t)(((int64_t)unit_pos.y + m_last_pos.y) >> 1);
+
+			m_velocity.x = params.tick_rate * dx;
+			m_velocity.y = params.tick_rate * dy;
+
+			m_last_pos = unit_pos;
+			m_dt_last_pos_change = 0;
+		}
+
+		if ((m_velocity.x != 0 || m_velocity.y != 0) && m_dt_last_pos_change < tick_len) {
+			const glm::ivec2 step = { (int32_t)(((int64_t)delta * m_velocity.x) >> 16), (int32_t)(((int64_t)delta * m_velocity.y) >> 16) };
+			const int64_t correction = params.correction;
+			const int64_t one_minus_correction = 65536 - correction;
+
+			m_predicted_pos.x = (int32_t)(((int64_t)m_predicted_pos.x * one_minus_correction + (int64_t)m_corrected_pos.x * correction) >> 16);
+			m_predicted_pos.y = (int32_t)(((int64_t)m_predicted_pos.y * one_minus_correction + (int64_t)m_corrected_pos.y * correction) >> 16);
+
+			m_predicted_pos += step;
+			m_corrected_pos += step;
+		}
+	}
+
+	inline glm::ivec2 getScreenOffset() const
+	{
+		const glm::vec2 offset = { (m_predicted_pos.x - m_last_pos.x) / 65536.0f, (m_predicted_pos.y - m_last_pos.y) / 65536.0f };
+		const glm::vec2 screen_offset = toScreen(offset) + 0.5f;
+		return { (int)screen_offset.x, (int)screen_offset.y };
+	}
+
+	inline const glm::ivec2& getLastPos() const { return m_last_pos; }
+	inline const glm::ivec2& getPredictedPos() const { return m_predicted_pos; }
+
+	static inline glm::vec2 toScreen(glm::vec2 tile_pos)
+	{
+		const glm::vec2 scale_factors = { 32.0f / sqrtf(2.0f), 16.0f / sqrtf(2.0f) };
+		return scale_factors * glm::vec2(tile_pos.x - tile_pos.y, tile_pos.x + tile_pos.y);
+	}
+};
+
+}
@@ -120,6 +120,10 @@ void Config::SaveConfig()
 	jsonGraphics["bloom"] = App.bloom.active;
 	jsonGraphics["bloom_exposure"] = App.bloom.exposure.value;
 	jsonGraphics["bloom_gamma"] = App.bloom.gamma.value;
+	jsonGraphics["governor"] = App.governor.active;
+	jsonGraphics["governor_target_fps"] = App.governor.target_fps.value;
+	jsonGraphics["dynamic_resolution"] = App.dynamic_resolution.active;
+	jsonGraphics["dynamic_resolution_min_scale"] = App.dynamic_resolution.min_scale.value;
 	jsonGraphics["stretched_horizontal"] = App.viewport.stretched.x;
 	jsonGraphics["stretched_vertical"] = App.viewport.stretched.y;
 	jsonConfig["graphics"] = jsonGraphics;
@@ -265,6 +269,10 @@ void Config::LoadConfig()
 	App.bloom.active = d2gl::Config::GetBool("graphics", "bloom", App.bloom.active);
 	App.bloom.exposure.value = d2gl::Config::GetFloat("graphics", "bloom_exposure", App.bloom.exposure.value, App.bloom.exposure.min, App.bloom.exposure.max);
 	App.bloom.gamma.value = d2gl::Config::GetFloat("graphics", "bloom_gamma", App.bloom.gamma.value, App.bloom.gamma.min, App.bloom.gamma.max);
+	App.governor.active = d2gl::Config::GetBool("graphics", "governor", App.governor.active);
+	App.governor.target_fps.value = d2gl::Config::GetInt("graphics", "governor_target_fps", App.governor.target_fps.value, App.governor.target_fps.min, App.governor.target_fps.max);
+	App.dynamic_resolution.active = d2gl::Config::GetBool("graphics", "dynamic_resolution", App.dynamic_resolution.active);
+	App.dynamic_resolution.min_scale.value = d2gl::Config::GetFloat("graphics", "dynamic_resolution_min_scale", App.dynamic_resolution.min_scale.value, App.dynamic_resolution.min_scale.min, App.dynamic_resolution.min_scale.max);
 	App.viewport.stretched.x = d2gl::Config::GetBool("graphics", "stretched_horizontal", App.viewport.stretched.x);
 	App.viewport.stretched.y = d2gl::Config::GetBool("graphics", "stretched_vertical", App.viewport.stretched.y);
 
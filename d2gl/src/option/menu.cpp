@@ -19,6 +19,9 @@
 #include "pch.h"
 #include "menu.h"
 #include "d2/common.h"
+#include "graphic/gl_state.h"
+#include "graphic/resource_pool.h"
+#include "graphic/screen_capture.h"
 #include "helpers.h"
 #include "modules/hd_text.h"
 #include "modules/mini_map.h"
@@ -101,15 +104,23 @@ Menu::Menu()
 	io.ConfigFlags |= ImGuiConfigFlags_NoMouseCursorChange;
 	io.IniFilename = NULL;
 
-	BufferData font1 = helpers::loadFile("assets\\fonts\\ExocetBlizzardMedium.otf");
-	BufferData font2 = helpers::loadFile("assets\\fonts\\Formal436BT.ttf");
+	auto font1 = helpers::loadFile("assets\\fonts\\ExocetBlizzardMedium.otf");
+	auto font2 = helpers::loadFile("assets\\fonts\\Formal436BT.ttf");
+	m_font_assets = { font1, font2 };
+
+	// Font data is a shared read-only asset, the atlas must not free it.
+	ImFontConfig font_cfg;
+	font_cfg.FontDataOwnedByAtlas = false;
+	auto addFont = [&](const AssetRef& font, float size) {
+		return font && font->getSize() ? io.Fonts->AddFontFromMemoryTTF((void*)font->getData(), (int)font->getSize(), size, &font_cfg) : io.Fonts->Fonts[0];
+	};
 
 	io.Fonts->AddFontDefault();
-	m_fonts[20] = font1.size ? io.Fonts->AddFontFromMemoryTTF((void*)font1.data, font1.size, 20.0f) : io.Fonts->Fonts[0];
-	m_fonts[17] = font1.size ? io.Fonts->AddFontFromMemoryTTF((void*)font1.data, font1.size, 17.0f) : io.Fonts->Fonts[0];
-	m_fonts[15] = font1.size ? io.Fonts->AddFontFromMemoryTTF((void*)font1.data, font1.size, 15.0f) : io.Fonts->Fonts[0];
-	m_fonts[14] = font2.size ? io.Fonts->AddFontFromMemoryTTF((void*)font2.data, font2.size, 14.0f) : io.Fonts->Fonts[0];
-	m_fonts[12] = font2.size ? io.Fonts->AddFontFromMemoryTTF((void*)font2.data, font2.size, 12.0f) : io.Fonts->Fonts[0];
+	m_fonts[20] = addFont(font1, 20.0f);
+	m_fonts[17] = addFont(font1, 17.0f);
+	m_fonts[15] = addFont(font1, 15.0f);
+	m_fonts[14] = addFont(font2, 14.0f);
+	m_fonts[12] = addFont(font2, 12.0f);
 
 	App.menu_title += (ISGLIDE3X() ? " (Glide / " : " (DDraw / ");
 	App.menu_title += "OpenGL: " + App.gl_ver_str + " / D2LoD: " + helpers::getVersionString() + " / " + helpers::getLangString() + ")";
@@ -326,6 +337,17 @@ void Menu::draw()
 				ImGui::EndDisabled();
 			ImGui::EndDisabled();
 			drawSeparator();
+			drawCheckbox_m("Performance Governor", App.governor.active, "", governor);
+			drawCheckbox_m("Dynamic Resolution", App.dynamic_resolution.active, "", dynamic_resolution);
+			ImGui::BeginDisabled(!App.governor.active && !App.dynamic_resolution.active);
+				drawSlider_m(int, "", App.governor.target_fps, "%d", "", governor_target_fps);
+				drawDescription("Reduces post-processing step by step while below target fps.", m_colors[Color::Gray], 12);
+			ImGui::EndDisabled();
+			ImGui::BeginDisabled(!App.dynamic_resolution.active);
+				drawSlider_m(float, "", App.dynamic_resolution.min_scale, "%.2f", "", dynamic_resolution_min_scale);
+				drawDescription("Lowest render scale of the upscaler passes.", m_colors[Color::Gray], 12);
+			ImGui::EndDisabled();
+			drawSeparator();
 			drawLabel("Stretched Viewport", m_colors[Color::Orange]);
 			drawCheckbox_m("Horizontal", App.viewport.stretched.x, "", stretched_horizontal)
 			{
@@ -400,6 +422,15 @@ void Menu::draw()
 			drawCheckbox_m("Show Item Quantity", App.show_item_quantity, "Show item quantity on bottom left corner of icon.", show_item_quantity);
 			drawSeparator();
 			drawCheckbox_m("Show FPS", App.show_fps, "FPS Counter on bottom center.", show_fps);
+			drawSeparator();
+			bool capturing = ScreenCapture::Instance().isRecording();
+			bool opt_capturing = capturing;
+			if (drawCheckbox("Record Frames", &capturing, "Stream every frame to CaptureXXX.y4m for frame pacing analysis.", &opt_capturing)) {
+				if (capturing)
+					ScreenCapture::Instance().startRecording(CaptureFormat::Y4M, 1);
+				else
+					ScreenCapture::Instance().stopRecording();
+			}
 			childEnd();
 			tabEnd();
 		}
@@ -451,6 +482,33 @@ void Menu::draw()
 			ImGuiIO& io = ImGui::GetIO();
 			ImGui::PushFont(io.Fonts->Fonts[0]);
 			ImGui::Checkbox("Check6", (bool*)(&App.var[6]));
+			bool recording = modules::MotionPrediction::Instance().isRecording();
+			if (ImGui::Checkbox("Record motion trace", &recording))
+				modules::MotionPrediction::Instance().toggleRecording(recording);
+			static int capture_interval = 1;
+			static int capture_format = 0;
+			bool capturing = ScreenCapture::Instance().isRecording();
+			if (ImGui::Checkbox("Record frames", &capturing)) {
+				if (capturing)
+					ScreenCapture::Instance().startRecording((CaptureFormat)capture_format, (uint32_t)capture_interval);
+				else
+					ScreenCapture::Instance().stopRecording();
+			}
+			ImGui::SliderInt("Capture interval", &capture_interval, 1, 10);
+			ImGui::Combo("Capture format", &capture_format, "Y4M\0Raw BGRA\0");
+			ImGui::Text("Capture: %u written, %u dropped", ScreenCapture::Instance().getWrittenFrames(), ScreenCapture::Instance().getDroppedFrames());
+			const auto& particle_stats = modules::MotionPrediction::Instance().getParticleStats();
+			ImGui::Text("Particles per second: %u lookups, %u inserts, %u evictions, %u overflows, max probe %u", particle_stats.lookups, particle_stats.inserts, particle_stats.evictions, particle_stats.overflows, particle_stats.max_probe);
+			ImGui::Text("Governor level: %u", App.governor.level);
+			ImGui::Text("Render scale: %.2f", App.dynamic_resolution.scale);
+			for (size_t i = 0; i < (size_t)GLStateCall::Count; i++) {
+				const auto& counter = GLState::Instance().getCounter((GLStateCall)i);
+				ImGui::Text("GL %s: %u issued, %u filtered", GLState::getCallName((GLStateCall)i), counter.issued, counter.filtered);
+			}
+			const auto& pool_stats = ResourcePool::Instance().getStats();
+			ImGui::Text("Resource pool: %u free (%.1f MB), %u reused, %u created, %u deleted", ResourcePool::Instance().getCount(), ResourcePool::Instance().getBytes() / 1048576.0, pool_stats.reused, pool_stats.created, pool_stats.deleted);
+			const auto& asset_stats = AssetCache::Instance().getStats();
+			ImGui::Text("Asset cache: %u shared, %u mapped, %u extracted", asset_stats.shared, asset_stats.mapped, asset_stats.extracted);
 			ImGui::PopFont();
 			tabEnd();
 		}
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include "asset_cache.h"
 #include <imgui/imgui.h>
 
 namespace d2gl {
@@ -45,6 +46,7 @@ class Menu {
 	bool m_changed = false;
 	bool m_opt_changed = false;
 	std::unordered_map<int, ImFont*> m_fonts;
+	std::vector<AssetRef> m_font_assets;
 	std::unordered_map<Color, ImVec4> m_colors;
 	Options m_options;
 	bool m_ignore_font = false;
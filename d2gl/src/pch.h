@@ -22,18 +22,22 @@
 #include <windows.h>
 #include <windowsx.h>
 
+#include <share.h>
 #include <shellapi.h>
 #include <stdint.h>
 #include <timeapi.h>
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <deque>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <mutex>
 #include <numeric>
 #include <thread>
 #include <unordered_map>
@@ -83,11 +83,6 @@ struct OffsetDefault {
 	int add = 0;
 };
 
-struct BufferData {
-	size_t size = 0;
-	uint8_t* data = nullptr;
-};
-
 struct ImageData {
 	int width = 0;
 	int height = 0;
@@ -0,0 +1,268 @@
+/*
+	D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+	Copyright (C) 2023  Bayaraa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define BLIT_AVX2
+#else
+#include <cpuid.h>
+#define BLIT_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Kept free of DirectDraw and game dependencies so tools/blit_bench can run the kernels offline.
+
+namespace d2gl::blit {
+
+enum class Isa {
+	Scalar,
+	SSE2,
+	AVX2,
+};
+
+// Widths are in bytes, fill patterns hold the color repeated to 32 bits (see fillPattern).
+typedef void (*FillFunc)(uint8_t* dst, uint32_t dst_pitch, uint32_t width, uint32_t height, uint32_t pattern);
+typedef void (*CopyFunc)(uint8_t* dst, uint32_t dst_pitch, const uint8_t* src, uint32_t src_pitch, uint32_t width, uint32_t height);
+typedef void (*CopyKeyFunc)(uint8_t* dst, uint32_t dst_pitch, const uint8_t* src, uint32_t src_pitch, uint32_t width, uint32_t height, uint32_t key);
+
+struct Kernels {
+	Isa isa;
+	FillFunc fill;
+	CopyFunc copy;
+	CopyKeyFunc copy_key[3]; // 8, 16, 32 bpp
+};
+
+inline uint32_t fillPattern(uint32_t color, uint32_t bpp)
+{
+	if (bpp == 8)
+		return (color & 0xFF) * 0x01010101;
+	if (bpp == 16)
+		return (color & 0xFFFF) * 0x00010001;
+
+	return color;
+}
+
+inline void fillTail(uint8_t* dst, uint32_t size, uint32_t pattern)
+{
+	for (; size >= 4; size -= 4, dst += 4)
+		memcpy(dst, &pattern, 4);
+	memcpy(dst, &pattern, size);
+}
+
+template <typename T>
+inline void copyKeyTail(uint8_t* dst, const uint8_t* src, uint32_t size, uint32_t key)
+{
+	for (uint32_t x = 0; x < size; x += sizeof(T)) {
+		T pixel;
+		memcpy(&pixel, src + x, sizeof(T));
+		if (pixel != (T)key)
+			memcpy(dst + x, &pixel, sizeof(T));
+	}
+}
+
+// Fills and plain copies stay on the CRT for every isa. Its memset/memcpy are already vectorised
+// and SSE2/AVX2 loops measured no faster on D2 rect sizes (tools/blit_bench).
+inline void fillRows(uint8_t* dst, uint32_t dst_pitch, uint32_t width, uint32_t height, uint32_t pattern)
+{
+	if (!height)
+		return;
+
+	if ((pattern & 0xFF) * 0x01010101 == pattern) {
+		for (uint32_t y = 0; y < height; y++)
+			memset(dst + y * dst_pitch, pattern & 0xFF, width);
+		return;
+	}
+
+	fillTail(dst, width, pattern);
+	for (uint32_t y = 1; y < height; y++)
+		memcpy(dst + y * dst_pitch, dst, width);
+}
+
+inline void copyRows(uint8_t* dst, uint32_t dst_pitch, const uint8_t* src, uint32_t src_pitch, uint32_t width, uint32_t height)
+{
+	if (width == dst_pitch && width == src_pitch) {
+		memcpy(dst, src, width * height);
+		return;
+	}
+
+	for (uint32_t y = 0; y < height; y++, dst += dst_pitch, src += src_pitch)
+		memcpy(dst, src, width);
+}
+
+template <typename T>
+inline void copyKeyScalar(uint8_t* dst, uint32_t dst_pitch, const uint8_t* src, uint32_t src_pitch, uint32_t width, uint32_t height, uint32_t key)
+{
+	for (uint32_t y = 0; y < height; y++, dst += dst_pitch, src += src_pitch)
+		copyKeyTail<T>(dst, src, width, key);
+}
+
+template <typename T>
+inline void copyKeySSE2(uint8_t* dst, uint32_t dst_pitch, const uint8_t* src, uint32_t src_pitch, uint32_t width, uint32_t height, uint32_t key)
+{
+	const __m128i key_value = _mm_set1_epi32((int)fillPattern(key, sizeof(T) * 8));
+
+	for (uint32_t y = 0; y < height; y++, dst += dst_pitch, src += src_pitch) {
+		uint32_t x = 0;
+		for (; x + 16 <= width; x += 16) {
+			const __m128i pixels = _mm_loadu_si128((const __m128i*)(src + x));
+			__m128i mask;
+			if constexpr (sizeof(T) == 1)
+				mask = _mm_cmpeq_epi8(pixels, key_value);
+			else if constexpr (sizeof(T) == 2)
+				mask = _mm_cmpeq_epi16(pixels, key_value);
+			else
+				mask = _mm_cmpeq_epi32(pixels, key_value);
+
+			// Sprites are mostly fully opaque or fully keyed runs, skip the blend for those.
+			const int keyed = _mm_movemask_epi8(mask);
+			if (keyed == 0xFFFF)
+				continue;
+			if (keyed == 0) {
+				_mm_storeu_si128((__m128i*)(dst + x), pixels);
+				continue;
+			}
+
+			const __m128i target = _mm_loadu_si128((const __m128i*)(dst + x));
+			_mm_storeu_si128((__m128i*)(dst + x), _mm_or_si128(_mm_and_si128(mask, target), _mm_andnot_si128(mask, pixels)));
+		}
+		copyKeyTail<T>(dst + x, src + x, width - x, key);
+	}
+}
+
+template <typename T>
+BLIT_AVX2 inline void copyKeyAVX2(uint8_t* dst, uint32_t dst_pitch, const uint8_t* src, uint32_t src_pitch, uint32_t width, uint32_t height, uint32_t key)
+{
+	const __m256i key_value = _mm256_set1_epi32((int)fillPattern(key, sizeof(T) * 8));
+
+	for (uint32_t y = 0; y < height; y++, dst += dst_pitch, src += src_pitch) {
+		uint32_t x = 0;
+		for (; x + 32 <= width; x += 32) {
+			const __m256i pixels = _mm256_loadu_si256((const __m256i*)(src + x));
+			__m256i mask;
+			if constexpr (sizeof(T) == 1)
+				mask = _mm256_cmpeq_epi8(pixels, key_value);
+			else if constexpr (sizeof(T) == 2)
+				mask = _mm256_cmpeq_epi16(pixels, key_value);
+			else
+				mask = _mm256_cmpeq_epi32(pixels, key_value);
+
+			const uint32_t keyed = (uint32_t)_mm256_movemask_epi8(mask);
+			if (keyed == 0xFFFFFFFF)
+				continue;
+			if (keyed == 0) {
+				_mm256_storeu_si256((__m256i*)(dst + x), pixels);
+				continue;
+			}
+
+			const __m256i target = _mm256_loadu_si256((const __m256i*)(dst + x));
+			_mm256_storeu_si256((__m256i*)(dst + x), _mm256_blendv_epi8(pixels, target, mask));
+		}
+		copyKeyTail<T>(dst + x, src + x, width - x, key);
+	}
+}
+
+inline void cpuid(uint32_t leaf, uint32_t sub_leaf, uint32_t regs[4])
+{
+#ifdef _MSC_VER
+	__cpuidex((int*)regs, (int)leaf, (int)sub_leaf);
+#else
+	__cpuid_count(leaf, sub_leaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+inline uint64_t xgetbv()
+{
+#ifdef _MSC_VER
+	return _xgetbv(0);
+#else
+	uint32_t low, high;
+	__asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+	return ((uint64_t)high << 32) | low;
+#endif
+}
+
+inline Isa detectIsa()
+{
+	uint32_t regs[4] = { 0 };
+	cpuid(0, 0, regs);
+	const uint32_t max_leaf = regs[0];
+
+	cpuid(1, 0, regs);
+	if (!(regs[3] & (1 << 26)))
+		return Isa::Scalar;
+
+	// AVX state must also be enabled by the OS (OSXSAVE + XCR0 xmm/ymm bits).
+	const bool avx = (regs[2] & (1 << 27)) && (regs[2] & (1 << 28)) && (xgetbv() & 0x6) == 0x6;
+	if (avx && max_leaf >= 7) {
+		cpuid(7, 0, regs);
+		if (regs[1] & (1 << 5))
+			return Isa::AVX2;
+	}
+
+	return Isa::SSE2;
+}
+
+inline const char* getIsaName(Isa isa)
+{
+	switch (isa) {
+		case Isa::SSE2: return "SSE2";
+		case Isa::AVX2: return "AVX2";
+		default: return "Scalar";
+	}
+}
+
+inline const Kernels& getKernels(Isa isa)
+{
+	static const Kernels kernels[] = {
+		{ Isa::Scalar, fillRows, copyRows, { copyKeyScalar<uint8_t>, copyKeyScalar<uint16_t>, copyKeyScalar<uint32_t> } },
+		{ Isa::SSE2, fillRows, copyRows, { copyKeySSE2<uint8_t>, copyKeySSE2<uint16_t>, copyKeySSE2<uint32_t> } },
+		{ Isa::AVX2, fillRows, copyRows, { copyKeyAVX2<uint8_t>, copyKeyAVX2<uint16_t>, copyKeyAVX2<uint32_t> } },
+	};
+	return kernels[(int)isa];
+}
+
+inline const Kernels& getActiveKernels()
+{
+	static const Kernels& kernels = getKernels(detectIsa());
+	return kernels;
+}
+
+inline uint32_t getKeyIndex(uint32_t bpp)
+{
+	return bpp == 8 ? 0 : (bpp == 16 ? 1 : 2);
+}
+
+// Narrow rows spend most of their time in the scalar tail, they step down to the next narrower
+// kernel: AVX2 below two vectors, SSE2 below one (tools/blit_bench cell and glyph rects).
+inline CopyKeyFunc getCopyKey(const Kernels& kernels, uint32_t bpp, uint32_t width)
+{
+	Isa isa = kernels.isa;
+	if (isa == Isa::AVX2 && width < sizeof(__m256i) * 2)
+		isa = Isa::SSE2;
+	if (isa == Isa::SSE2 && width < sizeof(__m128i))
+		isa = Isa::Scalar;
+
+	return getKernels(isa).copy_key[getKeyIndex(bpp)];
+}
+
+}
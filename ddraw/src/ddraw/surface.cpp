@@ -33,6 +33,7 @@
 
 #include "pch.h"
 #include "surface.h"
+#include "blit.h"
 #include "direct_draw.h"
 #include "wrapper.h"
 
@@ -51,6 +52,11 @@ DirectDrawSurface::DirectDrawSurface(LPDDSURFACEDESC surface_desc)
 		}
 	}
 
+	if (m_flags & DDSD_CKSRCBLT) {
+		m_src_key = true;
+		m_src_key_value = surface_desc->ddckCKSrcBlt.dwColorSpaceLowValue;
+	}
+
 	if (m_caps & DDSCAPS_PRIMARYSURFACE) {
 		m_width = App.game.size.x;
 		m_height = App.game.size.y;
@@ -231,57 +237,7 @@ HRESULT __stdcall DirectDrawSurface::Blt(LPRECT in_dst_rect, LPDIRECTDRAWSURFACE
 
 	if (m_data && (flags & DDBLT_COLORFILL) && dst_w > 0 && dst_h > 0) {
 		uint8_t* dst = (uint8_t*)m_data + (dst_x * m_xpitch) + (m_ypitch * dst_y);
-		uint8_t* first_row = dst;
-		uint32_t dst_pitch = dst_w * m_xpitch;
-
-		if (m_bpp == 8) {
-			const auto color = (uint8_t)blt_fx->dwFillColor;
-
-			for (int i = 0; i < dst_h; i++) {
-				memset(dst, color, dst_pitch);
-				dst += m_ypitch;
-			}
-		} else if (m_bpp == 16) {
-			auto row1 = (uint16_t*)dst;
-			const auto color = (uint16_t)blt_fx->dwFillColor;
-
-			if ((color & 0xFF) == (color >> 8)) {
-				const auto c8 = (uint8_t)(color & 0xFF);
-
-				for (int i = 0; i < dst_h; i++) {
-					memset(dst, c8, dst_pitch);
-					dst += m_ypitch;
-				}
-			} else {
-				for (int i = 0; i < dst_w; i++)
-					row1[i] = color;
-
-				for (int i = 1; i < dst_h; i++) {
-					dst += m_ypitch;
-					memcpy(dst, first_row, dst_pitch);
-				}
-			}
-		} else if (m_bpp == 32) {
-			auto row1 = (uint32_t*)dst;
-			const auto color = blt_fx->dwFillColor;
-
-			if ((color & 0xFF) == ((color >> 8) & 0xFF) && (color & 0xFF) == ((color >> 16) & 0xFF) && (color & 0xFF) == ((color >> 24) & 0xFF)) {
-				const auto c8 = (uint8_t)(color & 0xFF);
-
-				for (int i = 0; i < dst_h; i++) {
-					memset(dst, c8, dst_pitch);
-					dst += m_ypitch;
-				}
-			} else {
-				for (int i = 0; i < dst_w; i++)
-					row1[i] = color;
-
-				for (int i = 1; i < dst_h; i++) {
-					dst += m_ypitch;
-					memcpy(dst, first_row, dst_pitch);
-				}
-			}
-		}
+		blit::getActiveKernels().fill(dst, m_ypitch, dst_w * m_xpitch, dst_h, blit::fillPattern(blt_fx->dwFillColor, m_bpp));
 	}
 
 	return DD_OK;
@@ -346,13 +302,12 @@ HRESULT __stdcall DirectDrawSurface::BltFast(DWORD x, DWORD y, LPDIRECTDRAWSURFA
 	if (src_surface && dst_w > 0 && dst_h > 0) {
 		auto src = (uint8_t*)src_surface->m_data + (src_x * src_surface->m_xpitch) + (src_surface->m_ypitch * src_y);
 		auto dst = (uint8_t*)m_data + (dst_x * m_xpitch) + (m_ypitch * dst_y);
-		uint32_t dst_pitch = dst_w * m_xpitch;
+		const auto& kernels = blit::getActiveKernels();
 
-		for (int i = 0; i < dst_h; i++) {
-			memcpy(dst, src, dst_pitch);
-			src += src_surface->m_ypitch;
-			dst += m_ypitch;
-		}
+		if ((flags & DDBLTFAST_SRCCOLORKEY) && src_surface->m_src_key)
+			blit::getCopyKey(kernels, m_bpp, dst_w * m_xpitch)(dst, m_ypitch, src, src_surface->m_ypitch, dst_w * m_xpitch, dst_h, src_surface->m_src_key_value);
+		else
+			kernels.copy(dst, m_ypitch, src, src_surface->m_ypitch, dst_w * m_xpitch, dst_h);
 	}
 
 	return DD_OK;
@@ -400,6 +355,20 @@ HRESULT __stdcall DirectDrawSurface::GetAttachedSurface(LPDDSCAPS caps, LPDIRECT
 	return DD_OK;
 }
 
+HRESULT __stdcall DirectDrawSurface::GetColorKey(DWORD flags, LPDDCOLORKEY color_key)
+{
+	if (!color_key || !(flags & DDCKEY_SRCBLT))
+		return DDERR_INVALIDPARAMS;
+
+	if (!m_src_key)
+		return DDERR_NOCOLORKEY;
+
+	color_key->dwColorSpaceLowValue = m_src_key_value;
+	color_key->dwColorSpaceHighValue = m_src_key_value;
+
+	return DD_OK;
+}
+
 HRESULT __stdcall DirectDrawSurface::GetPixelFormat(LPDDPIXELFORMAT pixel_format)
 {
 	if (pixel_format) {
@@ -473,6 +442,17 @@ HRESULT __stdcall DirectDrawSurface::Lock(LPRECT dst_rect, LPDDSURFACEDESC surfa
 	return GetSurfaceDesc(surface_desc);
 }
 
+HRESULT __stdcall DirectDrawSurface::SetColorKey(DWORD flags, LPDDCOLORKEY color_key)
+{
+	if (!(flags & DDCKEY_SRCBLT))
+		return DDERR_UNSUPPORTED;
+
+	m_src_key = color_key != nullptr;
+	m_src_key_value = color_key ? color_key->dwColorSpaceLowValue : 0;
+
+	return DD_OK;
+}
+
 HRESULT __stdcall DirectDrawSurface::SetPalette(LPDIRECTDRAWPALETTE palette)
 {
 	if (palette) {
@@ -38,6 +38,9 @@ class DirectDrawSurface : public IDirectDrawSurface {
 	void* m_data = nullptr;
 	DWORD m_xpitch = 0, m_ypitch = 0;
 
+	bool m_src_key = false;
+	DWORD m_src_key_value = 0;
+
 	BitmapInfo256* m_bmi = nullptr;
 	HBITMAP m_bitmap = nullptr;
 	HDC m_hdc = nullptr;
@@ -70,7 +73,7 @@ public:
 	STDMETHOD(GetBltStatus)(THIS_ DWORD) { return DD_OK; }
 	STDMETHOD(GetCaps)(THIS_ LPDDSCAPS) { return DDERR_UNSUPPORTED; }
 	STDMETHOD(GetClipper)(THIS_ LPDIRECTDRAWCLIPPER FAR*) { return DDERR_UNSUPPORTED; }
-	STDMETHOD(GetColorKey)(THIS_ DWORD, LPDDCOLORKEY) { return DDERR_UNSUPPORTED; }
+	STDMETHOD(GetColorKey)(THIS_ DWORD, LPDDCOLORKEY);
 	STDMETHOD(GetDC)(THIS_ HDC FAR*) { return DDERR_UNSUPPORTED; }
 	STDMETHOD(GetFlipStatus)(THIS_ DWORD) { return DD_OK; }
 	STDMETHOD(GetOverlayPosition)(THIS_ LPLONG, LPLONG) { return DDERR_UNSUPPORTED; }
@@ -83,7 +86,7 @@ public:
 	STDMETHOD(ReleaseDC)(THIS_ HDC) { return DDERR_UNSUPPORTED; }
 	STDMETHOD(Restore)(THIS) { return DDERR_UNSUPPORTED; }
 	STDMETHOD(SetClipper)(THIS_ LPDIRECTDRAWCLIPPER) { return DDERR_UNSUPPORTED; }
-	STDMETHOD(SetColorKey)(THIS_ DWORD, LPDDCOLORKEY) { return DDERR_UNSUPPORTED; }
+	STDMETHOD(SetColorKey)(THIS_ DWORD, LPDDCOLORKEY);
 	STDMETHOD(SetOverlayPosition)(THIS_ LONG, LONG) { return DDERR_UNSUPPORTED; }
 	STDMETHOD(SetPalette)(THIS_ LPDIRECTDRAWPALETTE);
 	STDMETHOD(Unlock)(THIS_ LPVOID);
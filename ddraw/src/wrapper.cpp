@@ -49,7 +49,10 @@ void Wrapper::onBufferSwap(bool flip)
 		return;
 	m_swapped = true;
 
-	ctx->getCommandBuffer()->gameTextureUpdate((uint8_t*)DDrawSurface->getData(), { App.game.size.x, App.game.size.y }, App.game.bpp == 8 ? 1 : 4);
+	const auto data = (uint8_t*)DDrawSurface->getData();
+	const uint32_t bit = App.game.bpp == 8 ? 1 : 4;
+	m_dirty_tiles.update(data, App.game.size, bit);
+	ctx->getCommandBuffer()->gameTextureUpdate(data, { App.game.size.x, App.game.size.y }, bit, m_dirty_tiles.getRegions());
 	ctx->presentFrame();
 }
 
@@ -100,6 +103,10 @@ HRESULT Wrapper::setDisplayMode(DWORD width, DWORD height, DWORD bpp)
 	App.game.size = { width, height };
 	trace_log("Game requested screen size: %d x %d", App.game.size.x, App.game.size.y);
 
+	// The game recreates its surfaces and the game texture may be reacquired, next swap uploads all of it.
+	if (DDrawWrapper)
+		DDrawWrapper->m_dirty_tiles.invalidate();
+
 	if (!App.video_test && App.hwnd && old_size != App.game.size) {
 		win32::setWindowMetrics();
 		win32::windowResize();
@@ -30,6 +30,7 @@ extern std::unique_ptr<Wrapper> DDrawWrapper;
 class Wrapper {
 	Context* ctx;
 	bool m_swapped = true;
+	DirtyTiles m_dirty_tiles;
 
 public:
 	Wrapper();
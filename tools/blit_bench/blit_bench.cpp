@@ -0,0 +1,211 @@
+/*
+D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+Copyright (C) 2023  Bayaraa
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	Benchmarks and cross-checks the DirectDrawSurface fill and blit kernels.
+
+	Build (x86/x64, no game client required):
+		g++ -std=c++17 -O2 -I ../../ddraw/src blit_bench.cpp -o blit_bench
+
+	Usage:
+		blit_bench [-ms N]
+
+	Every kernel runs over a set of rect sizes seen on the DDraw path (full screen
+	clears, loading screens, UI panels, belt and inventory cells) for about -ms N
+	milliseconds each (default 100). Color key blits are timed for every isa the
+	cpu supports and through the width based dispatch DirectDrawSurface uses, fills
+	and plain copies share the CRT path. Each result is checked
+	against a per pixel reference first; a mismatch fails the run.
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "ddraw/blit.h"
+
+using namespace d2gl;
+
+#define SURFACE_WIDTH 1068
+#define SURFACE_HEIGHT 600
+
+struct RectSize {
+	const char* name;
+	uint32_t width;
+	uint32_t height;
+};
+
+static const RectSize g_sizes[] = {
+	{ "screen 1068x600", 1068, 600 },
+	{ "screen 800x600", 800, 600 },
+	{ "loading 640x480", 640, 480 },
+	{ "panel 320x432", 320, 432 },
+	{ "belt 176x32", 176, 32 },
+	{ "cell 29x29", 29, 29 },
+	{ "glyph 13x16", 13, 16 },
+};
+
+enum class Op { Fill, Copy, CopyKey };
+
+struct Surface {
+	std::vector<uint8_t> data;
+	uint32_t pitch;
+};
+
+static Surface makeSurface(uint32_t bpp, uint32_t seed, bool keyed)
+{
+	Surface surface = { std::vector<uint8_t>(SURFACE_WIDTH * SURFACE_HEIGHT * bpp / 8), SURFACE_WIDTH * bpp / 8 };
+	for (size_t i = 0; i < surface.data.size(); i++) {
+		seed = seed * 1664525u + 1013904223u;
+		surface.data[i] = (uint8_t)(seed >> 24);
+	}
+
+	// Runs of key color with a few opaque pixels in between, like D2 sprites and panels.
+	if (keyed) {
+		const uint32_t xpitch = bpp / 8;
+		for (uint32_t y = 0; y < SURFACE_HEIGHT; y++) {
+			for (uint32_t x = 0; x < SURFACE_WIDTH; x++) {
+				if ((x / 24 + y / 8) % 3 == 0)
+					memset(&surface.data[y * surface.pitch + x * xpitch], 0, xpitch);
+			}
+		}
+	}
+
+	return surface;
+}
+
+static void reference(Op op, uint32_t bpp, const RectSize& size, Surface& dst, const Surface& src, uint32_t offset)
+{
+	const uint32_t xpitch = bpp / 8;
+	const uint32_t pattern = blit::fillPattern(0x12345678, bpp);
+
+	for (uint32_t y = 0; y < size.height; y++) {
+		for (uint32_t x = 0; x < size.width; x++) {
+			uint8_t* dst_pixel = &dst.data[(offset + y) * dst.pitch + (offset + x) * xpitch];
+			const uint8_t* src_pixel = &src.data[y * src.pitch + (offset + x) * xpitch];
+			if (op == Op::Fill)
+				memcpy(dst_pixel, &pattern, xpitch);
+			else if (op == Op::Copy || memcmp(src_pixel, "\0\0\0\0", xpitch))
+				memcpy(dst_pixel, src_pixel, xpitch);
+		}
+	}
+}
+
+static void run(const blit::Kernels& kernels, bool dispatch, Op op, uint32_t bpp, const RectSize& size, Surface& dst, const Surface& src, uint32_t offset)
+{
+	const uint32_t xpitch = bpp / 8;
+	uint8_t* dst_ptr = dst.data.data() + offset * xpitch + offset * dst.pitch;
+	const uint8_t* src_ptr = src.data.data() + offset * xpitch;
+	const uint32_t width = size.width * xpitch;
+
+	switch (op) {
+		case Op::Fill: kernels.fill(dst_ptr, dst.pitch, width, size.height, blit::fillPattern(0x12345678, bpp)); break;
+		case Op::Copy: kernels.copy(dst_ptr, dst.pitch, src_ptr, src.pitch, width, size.height); break;
+		case Op::CopyKey: {
+			const auto copy_key = dispatch ? blit::getCopyKey(kernels, bpp, width) : kernels.copy_key[blit::getKeyIndex(bpp)];
+			copy_key(dst_ptr, dst.pitch, src_ptr, src.pitch, width, size.height, 0);
+			break;
+		}
+	}
+}
+
+static bool verify(const blit::Kernels& kernels, bool dispatch, Op op, uint32_t bpp, const RectSize& size, const Surface& src)
+{
+	// Odd offsets keep rows unaligned and catch tail handling errors.
+	const uint32_t offset = size.width < SURFACE_WIDTH - 8 && size.height < SURFACE_HEIGHT ? 3 : 0;
+
+	Surface expected = makeSurface(bpp, 7, false);
+	Surface result = expected;
+	reference(op, bpp, size, expected, src, offset);
+	run(kernels, dispatch, op, bpp, size, result, src, offset);
+
+	return expected.data == result.data;
+}
+
+static double bench(const blit::Kernels& kernels, bool dispatch, Op op, uint32_t bpp, const RectSize& size, Surface& dst, const Surface& src, double duration_ms)
+{
+	using clock = std::chrono::steady_clock;
+
+	uint64_t iterations = 0;
+	const auto start = clock::now();
+	double elapsed = 0.0;
+	do {
+		for (uint32_t i = 0; i < 16; i++)
+			run(kernels, dispatch, op, bpp, size, dst, src, 0);
+		iterations += 16;
+		elapsed = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+	} while (elapsed < duration_ms);
+
+	return elapsed * 1000.0 / iterations;
+}
+
+int main(int argc, char** argv)
+{
+	double duration_ms = 100.0;
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-ms") && i + 1 < argc)
+			duration_ms = atof(argv[++i]);
+	}
+
+	const blit::Isa detected = blit::detectIsa();
+	printf("detected %s\n", blit::getIsaName(detected));
+
+	static const Op ops[] = { Op::Fill, Op::Copy, Op::CopyKey };
+	static const char* op_names[] = { "fill", "copy", "copy key" };
+	static const uint32_t bpps[] = { 8, 16, 32 };
+
+	bool failed = false;
+	for (auto op : ops) {
+		for (auto bpp : bpps) {
+			printf("\n%s %ubpp (us per call)\n", op_names[(int)op], bpp);
+
+			const Surface src = makeSurface(bpp, 1, op == Op::CopyKey);
+			Surface dst = makeSurface(bpp, 2, false);
+
+			for (auto& size : g_sizes) {
+				printf("  %-16s", size.name);
+				double scalar_us = 0.0;
+				// The last column for color key blits is the detected isa through getCopyKey.
+				const int max_isa = op == Op::CopyKey ? (int)detected + 1 : 0;
+				for (int isa = 0; isa <= max_isa; isa++) {
+					const bool dispatch = isa > (int)detected;
+					const auto& kernels = blit::getKernels(dispatch ? detected : (blit::Isa)isa);
+					const char* name = dispatch ? "dispatch" : blit::getIsaName(kernels.isa);
+					if (!verify(kernels, dispatch, op, bpp, size, src)) {
+						printf(" | %s MISMATCH", name);
+						failed = true;
+						continue;
+					}
+
+					const double us = bench(kernels, dispatch, op, bpp, size, dst, src, duration_ms);
+					if (isa == 0) {
+						scalar_us = us;
+						printf(" | %s %8.2f", op == Op::CopyKey ? name : "CRT", us);
+					} else
+						printf(" | %s %8.2f (%.2fx)", name, us, scalar_us / us);
+				}
+				printf("\n");
+			}
+		}
+	}
+
+	return failed ? 1 : 0;
+}
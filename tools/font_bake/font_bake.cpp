@@ -0,0 +1,150 @@
+/*
+D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+Copyright (C) 2023  Bayaraa
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	Bakes an HD text glyph set (data.csv + <n>.png atlases) into a single atlas.bin.
+
+	Build (any platform):
+		g++ -std=c++17 -O2 -I ../../d2gl/src -I ../../d2gl/vendor/include font_bake.cpp -o font_bake
+
+	Usage:
+		font_bake <atlas_dir> [output]
+
+	<atlas_dir> is an extracted assets\atlases\<name> folder. The output defaults to
+	<atlas_dir>/atlas.bin and must be packed next to data.csv in the mpq. Glyph metrics
+	are stored already scaled the way GlyphSet::loadData computes them.
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb/stb_image.h>
+
+#include "modules/hd_text/font_atlas.h"
+
+using namespace d2gl;
+
+static std::vector<std::string> splitToVector(const std::string& str, char delimeter = ',')
+{
+	std::vector<std::string> segments = { "" };
+	for (auto& c : str) {
+		if (c == delimeter)
+			segments.push_back("");
+		else
+			segments.back().push_back(c);
+	}
+	return segments;
+}
+
+static bool loadLayer(const std::string& path, FontAtlasHeader& header, std::vector<uint8_t>& layers)
+{
+	int width, height, bit;
+	stbi_set_flip_vertically_on_load(1);
+	uint8_t* data = stbi_load(path.c_str(), &width, &height, &bit, 4);
+	if (!data) {
+		fprintf(stderr, "Could not decode: %s\n", path.c_str());
+		return false;
+	}
+
+	if (header.layer_count == 0) {
+		header.layer_width = (uint32_t)width;
+		header.layer_height = (uint32_t)height;
+	} else if (header.layer_width != (uint32_t)width || header.layer_height != (uint32_t)height) {
+		fprintf(stderr, "Atlas size mismatch: %s (%dx%d)\n", path.c_str(), width, height);
+		stbi_image_free(data);
+		return false;
+	}
+
+	layers.insert(layers.end(), data, data + (size_t)width * height * 4);
+	header.layer_count++;
+	stbi_image_free(data);
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		fprintf(stderr, "Usage: font_bake <atlas_dir> [output]\n");
+		return 1;
+	}
+
+	const std::string dir = argv[1];
+	const std::string output = argc > 2 ? argv[2] : dir + "/atlas.bin";
+
+	std::ifstream csv(dir + "/data.csv");
+	if (!csv) {
+		fprintf(stderr, "Could not open: %s/data.csv\n", dir.c_str());
+		return 1;
+	}
+
+	FontAtlasHeader header = { FONT_ATLAS_MAGIC, FONT_ATLAS_VERSION, 0, 0, 0, 0 };
+	std::vector<FontAtlasGlyph> glyphs;
+	std::vector<uint8_t> layers;
+	int atlas_index = -1;
+
+	for (std::string line; std::getline(csv, line);) {
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+
+		auto cols = splitToVector(line);
+		if (cols.size() < 11)
+			continue;
+
+		const int index = std::atoi(cols[0].c_str());
+		if (atlas_index < index) {
+			if (!loadLayer(dir + "/" + cols[0] + ".png", header, layers))
+				return 1;
+			atlas_index = index;
+		}
+
+		const float coords[4] = { std::stof(cols[7]), std::stof(cols[8]), std::stof(cols[9]), std::stof(cols[10]) };
+		const float bounds[4] = { std::stof(cols[3]), std::stof(cols[4]), std::stof(cols[5]), std::stof(cols[6]) };
+
+		FontAtlasGlyph glyph;
+		glyph.code = (uint32_t)std::atoi(cols[1].c_str());
+		glyph.layer = header.layer_count - 1;
+		glyph.advance = std::stof(cols[2]) * 32.0f;
+		glyph.size[0] = coords[2] - coords[0];
+		glyph.size[1] = coords[3] - coords[1];
+		glyph.offset[0] = bounds[0] * 32.0f;
+		glyph.offset[1] = -bounds[3] * 32.0f;
+		for (int i = 0; i < 4; i++)
+			glyph.tex_coord[i] = coords[i] / 1024.0f;
+		glyphs.push_back(glyph);
+	}
+	header.glyph_count = (uint32_t)glyphs.size();
+
+	std::ofstream out(output, std::ios::binary);
+	if (!out) {
+		fprintf(stderr, "Could not write: %s\n", output.c_str());
+		return 1;
+	}
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)glyphs.data(), glyphs.size() * sizeof(FontAtlasGlyph));
+	out.write((const char*)layers.data(), layers.size());
+
+	printf("%s: %u glyphs, %u layers (%ux%u)\n", output.c_str(), header.glyph_count, header.layer_count, header.layer_width, header.layer_height);
+	return 0;
+}
@@ -0,0 +1,226 @@
+/*
+D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+Copyright (C) 2023  Bayaraa
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	Offline evaluation of the frame time governor and the dynamic resolution controller.
+
+	Build (any platform, no game client required):
+		g++ -std=c++17 -O2 -I ../../d2gl/src governor_eval.cpp -o governor_eval
+
+	Usage:
+		governor_eval [trace.txt] [-fps N] [-window N] [-cooldown N] [-up R] [-saving MS]
+
+	Without a trace file a set of synthetic load patterns is evaluated. A trace file
+	contains one full quality render time in ms per line; every governor level is
+	assumed to save -saving ms (default 2.0) of it. For dynamic resolution 70% of the
+	render time is assumed to scale with the pixel count of the upscaler passes.
+*/
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "graphic/frame_governor.h"
+
+using d2gl::DynamicResolution;
+using d2gl::DynamicResolutionParams;
+using d2gl::FrameGovernor;
+using d2gl::FrameGovernorParams;
+
+#define MAX_LEVEL 5
+#define SCALED_COST 0.7
+
+struct Scenario {
+	std::string name;
+	std::vector<double> frame_times;  // full quality render time per frame
+	double savings[MAX_LEVEL];        // ms saved by each step
+};
+
+struct Metrics {
+	uint32_t frames = 0;
+	uint32_t over_budget = 0;
+	uint32_t steps_down = 0;
+	uint32_t steps_up = 0;
+	uint32_t final_level = 0;
+	double mean_level = 0.0;
+};
+
+struct ScaleMetrics {
+	uint32_t frames = 0;
+	uint32_t over_budget = 0;
+	uint32_t changes = 0;
+	double mean_scale = 0.0;
+	double min_scale = 1.0;
+};
+
+static double noise(uint32_t& seed, double amount)
+{
+	seed = seed * 1664525u + 1013904223u;
+	return ((seed >> 8) / 16777216.0 - 0.5) * 2.0 * amount;
+}
+
+static Scenario synthetic(const std::string& name, const std::vector<std::pair<uint32_t, double>>& segments, double saving)
+{
+	Scenario scenario = { name, {}, {} };
+	uint32_t seed = 1;
+	for (auto& segment : segments) {
+		for (uint32_t i = 0; i < segment.first; i++)
+			scenario.frame_times.push_back(segment.second + noise(seed, segment.second * 0.1));
+	}
+	for (auto& s : scenario.savings)
+		s = saving;
+
+	return scenario;
+}
+
+static std::vector<Scenario> syntheticScenarios(double saving)
+{
+	return {
+		synthetic("light load", { { 3600, 9.0 } }, saving),
+		synthetic("heavy load", { { 3600, 24.0 } }, saving),
+		synthetic("short spikes", { { 600, 12.0 }, { 20, 40.0 }, { 600, 12.0 }, { 20, 40.0 }, { 600, 12.0 } }, saving),
+		synthetic("town to fight", { { 1200, 12.0 }, { 2400, 21.0 }, { 1800, 11.0 } }, saving),
+		synthetic("borderline", { { 7200, 17.5 } }, saving),
+	};
+}
+
+static bool loadTrace(const char* file_path, Scenario& scenario, double saving)
+{
+	std::ifstream file(file_path);
+	if (!file.is_open())
+		return false;
+
+	scenario.name = file_path;
+	double frame_time;
+	while (file >> frame_time)
+		scenario.frame_times.push_back(frame_time);
+	for (auto& s : scenario.savings)
+		s = saving;
+
+	return !scenario.frame_times.empty();
+}
+
+static Metrics evaluate(const Scenario& scenario, const FrameGovernorParams& params)
+{
+	Metrics metrics;
+	FrameGovernor governor;
+	governor.reset(MAX_LEVEL);
+
+	double level_sum = 0.0;
+	for (auto full_time : scenario.frame_times) {
+		double frame_time = full_time;
+		for (uint32_t i = 0; i < governor.getLevel(); i++)
+			frame_time -= scenario.savings[i];
+		frame_time = frame_time < 0.5 ? 0.5 : frame_time;
+
+		const uint32_t level = governor.getLevel();
+		if (governor.update(frame_time, params))
+			governor.getLevel() > level ? metrics.steps_down++ : metrics.steps_up++;
+
+		metrics.over_budget += frame_time > params.budget_ms;
+		level_sum += governor.getLevel();
+		metrics.frames++;
+	}
+	metrics.final_level = governor.getLevel();
+	metrics.mean_level = metrics.frames ? level_sum / metrics.frames : 0.0;
+
+	return metrics;
+}
+
+static ScaleMetrics evaluateScale(const Scenario& scenario, const DynamicResolutionParams& params)
+{
+	ScaleMetrics metrics;
+	DynamicResolution resolution;
+
+	double scale_sum = 0.0;
+	for (auto full_time : scenario.frame_times) {
+		const double scale = resolution.getScale();
+		const double frame_time = full_time * (1.0 - SCALED_COST + SCALED_COST * scale * scale);
+
+		metrics.changes += resolution.update(frame_time, params);
+		metrics.over_budget += frame_time > params.budget_ms;
+		metrics.min_scale = std::fmin(metrics.min_scale, resolution.getScale());
+		scale_sum += resolution.getScale();
+		metrics.frames++;
+	}
+	metrics.mean_scale = metrics.frames ? scale_sum / metrics.frames : 1.0;
+
+	return metrics;
+}
+
+int main(int argc, char** argv)
+{
+	FrameGovernorParams params;
+	double saving = 2.0;
+	const char* trace_file = nullptr;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-fps") && i + 1 < argc)
+			params.budget_ms = 1000.0 / atof(argv[++i]);
+		else if (!strcmp(argv[i], "-window") && i + 1 < argc)
+			params.window = (uint32_t)atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-cooldown") && i + 1 < argc)
+			params.cooldown = (uint32_t)atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-up") && i + 1 < argc)
+			params.up_ratio = atof(argv[++i]);
+		else if (!strcmp(argv[i], "-saving") && i + 1 < argc)
+			saving = atof(argv[++i]);
+		else
+			trace_file = argv[i];
+	}
+	if (params.window == 0 || params.budget_ms <= 0.0) {
+		fprintf(stderr, "Invalid parameters.\n");
+		return 1;
+	}
+	printf("budget %.2f ms, window %u, cooldown %u, up ratio %.2f, saving %.2f ms per level\n\n", params.budget_ms, params.window, params.cooldown, params.up_ratio, saving);
+
+	std::vector<Scenario> scenarios;
+	if (trace_file) {
+		Scenario scenario;
+		if (!loadTrace(trace_file, scenario, saving)) {
+			fprintf(stderr, "Could not read trace: %s\n", trace_file);
+			return 1;
+		}
+		scenarios.push_back(scenario);
+	} else
+		scenarios = syntheticScenarios(saving);
+
+	printf("governor\n");
+	for (auto& scenario : scenarios) {
+		const auto metrics = evaluate(scenario, params);
+		printf("  %-16s frames %6u | over budget %5.1f%% | down %3u, up %3u | level mean %.2f, final %u\n", scenario.name.c_str(), metrics.frames,
+			100.0 * metrics.over_budget / metrics.frames, metrics.steps_down, metrics.steps_up, metrics.mean_level, metrics.final_level);
+	}
+
+	DynamicResolutionParams scale_params;
+	scale_params.budget_ms = params.budget_ms;
+
+	printf("\ndynamic resolution\n");
+	for (auto& scenario : scenarios) {
+		const auto metrics = evaluateScale(scenario, scale_params);
+		printf("  %-16s frames %6u | over budget %5.1f%% | changes %4u | scale mean %.2f, min %.2f\n", scenario.name.c_str(), metrics.frames,
+			100.0 * metrics.over_budget / metrics.frames, metrics.changes, metrics.mean_scale, metrics.min_scale);
+	}
+
+	return 0;
+}
@@ -0,0 +1,268 @@
+/*
+D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+Copyright (C) 2023  Bayaraa
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+	Offline evaluation of the unit motion predictor.
+
+	Build (any platform, no game client required):
+		g++ -std=c++17 -O2 -I ../../d2gl/src -I ../../d2gl/vendor/include motion_eval.cpp -o motion_eval
+
+	Usage:
+		motion_eval [trace.txt] [-tick N] [-correction N] [-reset N]
+
+	Without a trace file a set of synthetic paths is evaluated. Trace files are
+	recorded from a debug build (Debug tab > Record motion trace) and contain one
+	line per frame: "<frame_time_ms> <delta> <path_x> <path_y>" with the time since the
+	previous frame, the 16.16 ms delta the predictor was updated with (the averaged frame
+	time) and 16.16 tile positions.
+*/
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "modules/motion_prediction/unit_predictor.h"
+
+using d2gl::modules::UnitPredictor;
+using d2gl::modules::UnitPredictorParams;
+
+struct PathSample {
+	double time;
+	glm::ivec2 pos;
+};
+
+struct FrameSample {
+	double time;
+	int32_t delta;
+};
+
+struct Scenario {
+	std::string name;
+	std::vector<PathSample> samples;
+};
+
+struct Metrics {
+	double mean_error = 0.0;
+	double max_error = 0.0;
+	double jitter = 0.0;
+	uint32_t frames = 0;
+};
+
+// Game side position at time t is the last sample at or before t.
+static glm::ivec2 observedPos(const std::vector<PathSample>& samples, double t)
+{
+	size_t lo = 0, hi = samples.size();
+	while (hi - lo > 1) {
+		const size_t mid = (lo + hi) / 2;
+		if (samples[mid].time <= t)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	return samples[lo].pos;
+}
+
+// Reference motion is the piecewise linear path through the points where position changed.
+static std::vector<PathSample> changePoints(const std::vector<PathSample>& samples)
+{
+	std::vector<PathSample> points;
+	for (auto& sample : samples) {
+		if (points.empty() || points.back().pos != sample.pos)
+			points.push_back(sample);
+	}
+	if (points.back().time != samples.back().time)
+		points.push_back(samples.back());
+
+	return points;
+}
+
+static glm::vec2 referencePos(const std::vector<PathSample>& points, double t)
+{
+	if (t <= points.front().time)
+		return glm::vec2(points.front().pos) / 65536.0f;
+
+	for (size_t i = 1; i < points.size(); i++) {
+		if (t <= points[i].time) {
+			const auto& a = points[i - 1];
+			const auto& b = points[i];
+			const float k = (float)((t - a.time) / (b.time - a.time));
+			return (glm::vec2(a.pos) + (glm::vec2(b.pos) - glm::vec2(a.pos)) * k) / 65536.0f;
+		}
+	}
+	return glm::vec2(points.back().pos) / 65536.0f;
+}
+
+static Metrics evaluate(const std::vector<PathSample>& samples, const std::vector<FrameSample>& frames, const UnitPredictorParams& params)
+{
+	Metrics metrics;
+	const auto points = changePoints(samples);
+
+	UnitPredictor predictor;
+	predictor.update(samples.front().pos, 0, params);
+
+	double t = samples.front().time;
+	glm::vec2 prev_shown = { 0.0f, 0.0f }, prev_ref = { 0.0f, 0.0f };
+	double error_sum = 0.0, jitter_sum = 0.0;
+
+	// Frame i is presented frames[i].time after the previous one, the first after the start sample.
+	for (auto& frame : frames) {
+		t += frame.time;
+		if (t > samples.back().time + 1e-6)
+			break;
+
+		predictor.update(observedPos(samples, t), frame.delta, params);
+
+		const glm::vec2 shown = UnitPredictor::toScreen(glm::vec2(predictor.getLastPos()) / 65536.0f) + glm::vec2(predictor.getScreenOffset());
+		const glm::vec2 ref = UnitPredictor::toScreen(referencePos(points, t));
+
+		const double error = glm::length(shown - ref);
+		error_sum += error;
+		metrics.max_error = glm::max(metrics.max_error, error);
+
+		if (metrics.frames > 0) {
+			const glm::vec2 step_diff = (shown - prev_shown) - (ref - prev_ref);
+			jitter_sum += glm::dot(step_diff, step_diff);
+		}
+		prev_shown = shown;
+		prev_ref = ref;
+		metrics.frames++;
+	}
+
+	if (metrics.frames > 0)
+		metrics.mean_error = error_sum / metrics.frames;
+	if (metrics.frames > 1)
+		metrics.jitter = sqrt(jitter_sum / (metrics.frames - 1));
+
+	return metrics;
+}
+
+// Positions are advanced on 25 Hz game ticks, like the server driven Path updates.
+static Scenario synthetic(const std::string& name, const std::vector<std::pair<double, glm::vec2>>& legs)
+{
+	Scenario scenario = { name, {} };
+	glm::vec2 pos = { 5000.0f, 5000.0f };
+	double t = 0.0;
+
+	scenario.samples.push_back({ t, glm::ivec2(pos * 65536.0f) });
+	for (auto& leg : legs) {
+		const int ticks = (int)(leg.first * 25.0 / 1000.0);
+		for (int i = 0; i < ticks; i++) {
+			t += 40.0;
+			pos += leg.second / 25.0f;
+			scenario.samples.push_back({ t, glm::ivec2(pos * 65536.0f) });
+		}
+	}
+	return scenario;
+}
+
+static std::vector<Scenario> syntheticScenarios()
+{
+	return {
+		synthetic("walk east", { { 4000.0, { 4.0f, 0.0f } } }),
+		synthetic("run diagonal", { { 4000.0, { 6.0f, 6.0f } } }),
+		synthetic("stop and go", { { 1000.0, { 6.0f, 0.0f } }, { 400.0, { 0.0f, 0.0f } }, { 1000.0, { 0.0f, 6.0f } }, { 400.0, { 0.0f, 0.0f } } }),
+		synthetic("zig-zag", { { 600.0, { 6.0f, 0.0f } }, { 600.0, { 0.0f, 6.0f } }, { 600.0, { -6.0f, 0.0f } }, { 600.0, { 0.0f, -6.0f } } }),
+		synthetic("charge", { { 2000.0, { 14.0f, 0.0f } } }),
+	};
+}
+
+static bool loadTrace(const char* file_path, Scenario& scenario, std::vector<FrameSample>& frames)
+{
+	std::ifstream file(file_path);
+	if (!file.is_open())
+		return false;
+
+	scenario.name = file_path;
+	double t = 0.0, frame_time;
+	int32_t delta, x, y;
+	while (file >> frame_time >> delta >> x >> y) {
+		t += frame_time;
+		scenario.samples.push_back({ t, { x, y } });
+
+		// The first line is the start sample, every later one is a frame to replay.
+		if (scenario.samples.size() > 1)
+			frames.push_back({ frame_time, delta });
+	}
+	return scenario.samples.size() > 1;
+}
+
+static void printMetrics(const char* label, const Metrics& metrics)
+{
+	printf("  %-10s frames %6u | error mean %6.2f px, max %6.2f px | jitter %6.3f px\n", label, metrics.frames, metrics.mean_error, metrics.max_error, metrics.jitter);
+}
+
+int main(int argc, char** argv)
+{
+	UnitPredictorParams params;
+	const char* trace_file = nullptr;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-tick") && i + 1 < argc)
+			params.tick_rate = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-correction") && i + 1 < argc)
+			params.correction = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-reset") && i + 1 < argc)
+			params.reset_distance = atoi(argv[++i]);
+		else
+			trace_file = argv[i];
+	}
+	if (params.tick_rate <= 0) {
+		fprintf(stderr, "Invalid tick rate.\n");
+		return 1;
+	}
+	printf("tick %d Hz, correction %d, reset %d tiles\n", params.tick_rate, params.correction, params.reset_distance);
+
+	std::vector<Scenario> scenarios;
+	std::vector<FrameSample> recorded_frames;
+	if (trace_file) {
+		Scenario scenario;
+		if (!loadTrace(trace_file, scenario, recorded_frames)) {
+			fprintf(stderr, "Could not read trace: %s\n", trace_file);
+			return 1;
+		}
+		scenarios.push_back(scenario);
+	} else
+		scenarios = syntheticScenarios();
+
+	const int fps_list[] = { 60, 144, 240 };
+	for (auto& scenario : scenarios) {
+		printf("\n%s (%.1f s)\n", scenario.name.c_str(), (scenario.samples.back().time - scenario.samples.front().time) / 1000.0);
+
+		if (!recorded_frames.empty())
+			printMetrics("recorded", evaluate(scenario.samples, recorded_frames, params));
+
+		for (auto fps : fps_list) {
+			const double duration = scenario.samples.back().time - scenario.samples.front().time;
+			const FrameSample frame = { 1000.0 / fps, (int32_t)(65536.0 / fps) };
+			const std::vector<FrameSample> frames((size_t)(duration * fps / 1000.0 + 1e-6), frame);
+			char label[16];
+			snprintf(label, sizeof(label), "%d fps", fps);
+			printMetrics(label, evaluate(scenario.samples, frames, params));
+		}
+	}
+
+	return 0;
+}
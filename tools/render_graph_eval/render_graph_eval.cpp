@@ -0,0 +1,167 @@
+/*
+D2GL: Diablo 2 LoD Glide/DDraw to OpenGL Wrapper.
+Copyright (C) 2023  Bayaraa
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+	Offline check of the render graph compiler.
+
+	Build (any platform, no GL required):
+		g++ -std=c++17 -O2 -I ../../d2gl/src render_graph_eval.cpp -o render_graph_eval
+
+	Usage:
+		render_graph_eval
+
+	Compiles the pre-fx and post-fx graphs for every effect combination the way
+	Context builds them, prints the physical target allocation of each, verifies
+	that no pass reads the target it writes and that rejected graphs fail to compile.
+*/
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "graphic/render_graph.h"
+
+using d2gl::RenderGraph;
+using d2gl::RenderTargetDesc;
+
+enum Pass : uint32_t { BloomExtract, BlurH, BlurV, Composite, Upscale, Sharpen, Fxaa, Present };
+enum External : uint32_t { Scene, Game, Screen };
+
+static const char* g_pass_names[] = { "bloom extract", "blur h", "blur v", "composite", "upscale", "sharpen", "fxaa", "present" };
+
+static void buildPreFx(RenderGraph& graph, bool bloom)
+{
+	const RenderTargetDesc game_desc = { 800, 600, 1 };
+	const RenderTargetDesc bloom_desc = { 200, 150, 1 };
+
+	graph.clear();
+	const uint32_t scene = graph.importTarget(Scene, game_desc);
+	const uint32_t game = graph.importTarget(Game, game_desc);
+	std::vector<uint32_t> inputs = { scene };
+	if (bloom) {
+		uint32_t target = graph.createTarget(bloom_desc);
+		graph.addPass(BloomExtract, { scene }, target);
+		for (uint32_t i = 0; i < 4; i++) {
+			const uint32_t next = graph.createTarget(bloom_desc);
+			graph.addPass(i % 2 ? BlurV : BlurH, { target }, next);
+			target = next;
+		}
+		inputs.push_back(target);
+	}
+	graph.addPass(Composite, inputs, game);
+}
+
+static void buildPostFx(RenderGraph& graph, bool sharpen, bool fxaa, bool compute)
+{
+	const RenderTargetDesc vp_desc = { 1920, 1080, 1 };
+
+	graph.clear();
+	const uint32_t game = graph.importTarget(Game);
+	const uint32_t screen = graph.importTarget(Screen);
+	if (!sharpen && !fxaa) {
+		graph.addPass(Upscale, { game }, screen);
+		return;
+	}
+
+	uint32_t target = graph.createTarget(vp_desc);
+	graph.addPass(Upscale, { game }, target);
+	if (sharpen) {
+		const uint32_t next = fxaa ? graph.createTarget(vp_desc) : screen;
+		graph.addPass(Sharpen, { target }, next);
+		target = next;
+	}
+	if (fxaa) {
+		if (compute) {
+			const uint32_t next = graph.createTarget(vp_desc);
+			graph.addPass(Fxaa, { target }, next);
+			graph.addPass(Present, { next }, screen);
+		} else
+			graph.addPass(Fxaa, { target }, screen);
+	}
+}
+
+static bool report(const std::string& name, RenderGraph& graph)
+{
+	if (!graph.compile()) {
+		printf("%s: compile failed\n", name.c_str());
+		return false;
+	}
+
+	uint32_t transient = 0;
+	for (auto& physical : graph.getPhysicalTargets())
+		transient += !physical.imported;
+	printf("%s: %zu passes, %u transient targets\n", name.c_str(), graph.getPasses().size(), transient);
+
+	bool valid = true;
+	for (auto& pass : graph.getPasses()) {
+		std::string inputs;
+		for (auto input : pass.inputs) {
+			inputs += (inputs.empty() ? "" : ", ") + std::to_string(input);
+			valid &= input != pass.output;
+		}
+		printf("  %-14s [%s] -> %u\n", g_pass_names[pass.id], inputs.c_str(), pass.output);
+	}
+	if (!valid)
+		printf("  error: a pass reads its own output\n");
+
+	return valid;
+}
+
+int main()
+{
+	RenderGraph graph;
+	bool valid = true;
+
+	buildPreFx(graph, false);
+	valid &= report("pre-fx", graph);
+	buildPreFx(graph, true);
+	valid &= report("pre-fx bloom", graph);
+
+	for (int i = 0; i < 8; i++) {
+		const bool sharpen = i & 1, fxaa = i & 2, compute = i & 4;
+		if (compute && !fxaa)
+			continue;
+
+		buildPostFx(graph, sharpen, fxaa, compute);
+		valid &= report(std::string("post-fx") + (sharpen ? " sharpen" : "") + (fxaa ? " fxaa" : "") + (compute ? " compute" : ""), graph);
+	}
+
+	// Graphs the compiler has to reject.
+	graph.clear();
+	uint32_t target = graph.createTarget({ 4, 4, 1 });
+	graph.addPass(Sharpen, { target }, target);
+	const bool feedback = graph.compile();
+
+	graph.clear();
+	target = graph.createTarget({ 4, 4, 1 });
+	graph.addPass(Present, { target }, graph.importTarget(Screen));
+	const bool unwritten = graph.compile();
+
+	graph.clear();
+	target = graph.createTarget({ 4, 4, 1 });
+	graph.addPass(Upscale, {}, target);
+	graph.addPass(Upscale, {}, target);
+	const bool rewritten = graph.compile();
+
+	printf("rejects feedback %s, unwritten input %s, second write %s\n", feedback ? "no" : "yes", unwritten ? "no" : "yes", rewritten ? "no" : "yes");
+	valid &= !feedback && !unwritten && !rewritten;
+
+	printf("%s\n", valid ? "ok" : "FAILED");
+	return valid ? 0 : 1;
+}